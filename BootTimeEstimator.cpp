@@ -0,0 +1,130 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include "BootTimeEstimator.h"
+
+#define FLASHHEADER_SIZE	16u     /**< Length of block headers in flash memory */
+
+CBootTimeEstimator::CBootTimeEstimator(const TCostModel& model)
+:m_Model(model)
+{
+	if (m_Model.SpiClockHz <= 0.0)
+	{
+		m_Model.SpiClockHz = GetDefaultModel().SpiClockHz;
+	}
+}
+
+CBootTimeEstimator::TCostModel CBootTimeEstimator::GetDefaultModel()
+{
+	TCostModel model;
+	model.SpiClockHz = 25.0e6;
+	model.FastRead = false;
+	model.AddressBytes = 3;
+	model.HeaderOverheadUs = 2.0;
+	model.DMABytesPerUs = 200.0;
+	model.CoreBytesPerUs = 50.0;
+	model.FillBytesPerUs = 400.0;
+	model.InitCostUs = 100.0;
+	model.CallbackCostUs = 10.0;
+	return model;
+}
+
+CBootTimeEstimator::TBootTime CBootTimeEstimator::Empty()
+{
+	TBootTime time = {};
+	return time;
+}
+
+double CBootTimeEstimator::SpiTransferUs(uint64_t bytes) const
+{
+	//every transfer starts with the read command, the address and (fast read) a dummy byte
+	const uint64_t overhead = 1u + m_Model.AddressBytes + (m_Model.FastRead ? 1u : 0u);
+	return 8.0 * static_cast<double>(overhead + bytes) * 1.0e6 / m_Model.SpiClockHz;
+}
+
+void CBootTimeEstimator::AddBlock(TBootTime& time, bool fill, bool ignore, bool init, bool callback, uint32_t length, bool dmaaccess) const
+{
+	++time.Blocks;
+	time.StreamBytes += FLASHHEADER_SIZE;
+	time.HeaderUs += m_Model.HeaderOverheadUs;
+	time.TransferUs += SpiTransferUs(FLASHHEADER_SIZE);
+
+	if (ignore)
+	{
+		//payload is skipped by the boot rom (new read command for the next header)
+		++time.IgnoredBlocks;
+		return;
+	}
+
+	if (fill)
+	{
+		++time.FillBlocks;
+		time.FillBytes += length;
+		if (m_Model.FillBytesPerUs > 0.0)
+		{
+			time.FillUs += length / m_Model.FillBytesPerUs;
+		}
+	}
+	else if (length > 0)
+	{
+		const double throughput = dmaaccess ? m_Model.DMABytesPerUs : m_Model.CoreBytesPerUs;
+		time.StreamBytes += length;
+		time.PayloadBytes += length;
+		time.TransferUs += SpiTransferUs(length);
+		if (throughput > 0.0)
+		{
+			time.CopyUs += length / throughput;
+		}
+	}
+
+	if (init)
+	{
+		++time.InitBlocks;
+		time.ExecutionUs += m_Model.InitCostUs;
+	}
+
+	if (callback)
+	{
+		++time.CallbackBlocks;
+		time.ExecutionUs += m_Model.CallbackCostUs;
+	}
+}
+
+void CBootTimeEstimator::PrintComparison(const TBootTime& original, const TBootTime& patched) const
+{
+	struct Row
+	{
+		const char* text;
+		double original;
+		double patched;
+		int precision;
+	};
+	const Row rows[] =
+	{
+		{"Blocks", static_cast<double>(original.Blocks), static_cast<double>(patched.Blocks), 0},
+		{"Fill blocks", static_cast<double>(original.FillBlocks), static_cast<double>(patched.FillBlocks), 0},
+		{"Ignored blocks", static_cast<double>(original.IgnoredBlocks), static_cast<double>(patched.IgnoredBlocks), 0},
+		{"Init/callback blocks", static_cast<double>(original.InitBlocks + original.CallbackBlocks), static_cast<double>(patched.InitBlocks + patched.CallbackBlocks), 0},
+		{"Bytes read (SPI)", static_cast<double>(original.StreamBytes), static_cast<double>(patched.StreamBytes), 0},
+		{"Bytes copied", static_cast<double>(original.PayloadBytes), static_cast<double>(patched.PayloadBytes), 0},
+		{"Bytes filled", static_cast<double>(original.FillBytes), static_cast<double>(patched.FillBytes), 0},
+		{"Header processing [ms]", original.HeaderUs / 1000.0, patched.HeaderUs / 1000.0, 3},
+		{"SPI transfer [ms]", original.TransferUs / 1000.0, patched.TransferUs / 1000.0, 3},
+		{"Copy [ms]", original.CopyUs / 1000.0, patched.CopyUs / 1000.0, 3},
+		{"Fill [ms]", original.FillUs / 1000.0, patched.FillUs / 1000.0, 3},
+		{"Init/callback [ms]", original.ExecutionUs / 1000.0, patched.ExecutionUs / 1000.0, 3},
+		{"Estimated boot time [ms]", original.TotalUs() / 1000.0, patched.TotalUs() / 1000.0, 3},
+	};
+
+	std::cout << std::dec << "Boot time estimation (SPI clock " << m_Model.SpiClockHz / 1.0e6 << " MHz, "
+		<< (m_Model.FastRead ? "fast read, " : "standard read, ") << m_Model.AddressBytes << " address bytes)" << std::endl;
+	std::cout << std::left << std::setw(28) << "" << std::right << std::setw(14) << "original" << std::setw(14) << "patched" << std::setw(14) << "delta" << std::endl;
+	std::cout << std::fixed;
+	for (auto& i : rows)
+	{
+		std::cout << std::setprecision(i.precision) << std::left << std::setw(28) << i.text << std::right
+			<< std::setw(14) << i.original << std::setw(14) << i.patched << std::setw(14) << i.patched - i.original << std::endl;
+	}
+	std::cout.unsetf(std::ios_base::floatfield);
+	std::cout << std::setprecision(6) << std::endl;
+}
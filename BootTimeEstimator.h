@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+
+/** Cost model based boot time prediction for a block stream (no hardware in the loop). */
+class CBootTimeEstimator
+{
+public:
+	struct TCostModel
+	{
+		double	SpiClockHz;				/**< SPI clock */
+		bool	FastRead;				/**< 0xB read command (one additional dummy byte per transfer) */
+		uint32_t AddressBytes;			/**< number of address bytes of the SPI device */
+		double	HeaderOverheadUs;		/**< boot rom processing time per block header */
+		double	DMABytesPerUs;			/**< copy throughput for memories requiring DMA access */
+		double	CoreBytesPerUs;			/**< copy throughput for memories written by the core */
+		double	FillBytesPerUs;			/**< fill throughput */
+		double	InitCostUs;				/**< execution time of an init block */
+		double	CallbackCostUs;			/**< execution time of a callback */
+	};
+
+	struct TBootTime
+	{
+		uint32_t Blocks;
+		uint32_t FillBlocks;
+		uint32_t IgnoredBlocks;
+		uint32_t InitBlocks;
+		uint32_t CallbackBlocks;
+		uint64_t StreamBytes;			/**< bytes read from the boot device */
+		uint64_t PayloadBytes;			/**< bytes copied to the target */
+		uint64_t FillBytes;				/**< bytes filled on the target */
+		double	HeaderUs;
+		double	TransferUs;
+		double	CopyUs;
+		double	FillUs;
+		double	ExecutionUs;
+		double	TotalUs() const { return HeaderUs + TransferUs + CopyUs + FillUs + ExecutionUs; }
+	};
+
+	explicit CBootTimeEstimator(const TCostModel& model);
+
+	static TCostModel GetDefaultModel();
+	static TBootTime Empty();
+
+	void AddBlock(TBootTime& time, bool fill, bool ignore, bool init, bool callback, uint32_t length, bool dmaaccess) const;
+	void PrintComparison(const TBootTime& original, const TBootTime& patched) const;
+
+private:
+	double	SpiTransferUs(uint64_t bytes) const;
+	TCostModel m_Model;
+};
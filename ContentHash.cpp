@@ -0,0 +1,92 @@
+#include <cstring>
+#include "ContentHash.h"
+
+static const uint64_t HashC1 = 0x87c37b91114253d5ull;
+static const uint64_t HashC2 = 0x4cf5ad432745937full;
+
+uint64_t CContentHash::Mix(uint64_t value)
+{
+	value ^= value >> 33;
+	value *= 0xff51afd7ed558ccdull;
+	value ^= value >> 33;
+	value *= 0xc4ceb9fe1a85ec53ull;
+	value ^= value >> 33;
+	return value;
+}
+
+uint64_t CContentHash::Load64(const uint8_t* p)
+{
+	//the target and the host are both little endian, memcpy avoids unaligned accesses
+	uint64_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+CContentHash::THash128 CContentHash::Calc(const void* data, size_t length, uint64_t seed)
+{
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+	const size_t blocks = length / 16;
+	uint64_t h1 = seed;
+	uint64_t h2 = seed;
+
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		uint64_t k1 = Load64(p + i * 16);
+		uint64_t k2 = Load64(p + i * 16 + 8);
+
+		k1 *= HashC1; k1 = Rotl(k1, 31); k1 *= HashC2; h1 ^= k1;
+		h1 = Rotl(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+		k2 *= HashC2; k2 = Rotl(k2, 33); k2 *= HashC1; h2 ^= k2;
+		h2 = Rotl(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+	}
+
+	const uint8_t* tail = p + blocks * 16;
+	uint64_t k1 = 0;
+	uint64_t k2 = 0;
+	switch (length & 15)
+	{
+	case 15: k2 ^= static_cast<uint64_t>(tail[14]) << 48; [[fallthrough]];
+	case 14: k2 ^= static_cast<uint64_t>(tail[13]) << 40; [[fallthrough]];
+	case 13: k2 ^= static_cast<uint64_t>(tail[12]) << 32; [[fallthrough]];
+	case 12: k2 ^= static_cast<uint64_t>(tail[11]) << 24; [[fallthrough]];
+	case 11: k2 ^= static_cast<uint64_t>(tail[10]) << 16; [[fallthrough]];
+	case 10: k2 ^= static_cast<uint64_t>(tail[9]) << 8; [[fallthrough]];
+	case 9:  k2 ^= static_cast<uint64_t>(tail[8]);
+		k2 *= HashC2; k2 = Rotl(k2, 33); k2 *= HashC1; h2 ^= k2;
+		[[fallthrough]];
+	case 8: k1 ^= static_cast<uint64_t>(tail[7]) << 56; [[fallthrough]];
+	case 7: k1 ^= static_cast<uint64_t>(tail[6]) << 48; [[fallthrough]];
+	case 6: k1 ^= static_cast<uint64_t>(tail[5]) << 40; [[fallthrough]];
+	case 5: k1 ^= static_cast<uint64_t>(tail[4]) << 32; [[fallthrough]];
+	case 4: k1 ^= static_cast<uint64_t>(tail[3]) << 24; [[fallthrough]];
+	case 3: k1 ^= static_cast<uint64_t>(tail[2]) << 16; [[fallthrough]];
+	case 2: k1 ^= static_cast<uint64_t>(tail[1]) << 8; [[fallthrough]];
+	case 1: k1 ^= static_cast<uint64_t>(tail[0]);
+		k1 *= HashC1; k1 = Rotl(k1, 31); k1 *= HashC2; h1 ^= k1;
+		break;
+	default:
+		break;
+	}
+
+	h1 ^= static_cast<uint64_t>(length);
+	h2 ^= static_cast<uint64_t>(length);
+	h1 += h2;
+	h2 += h1;
+	h1 = Mix(h1);
+	h2 = Mix(h2);
+	h1 += h2;
+	h2 += h1;
+
+	THash128 hash;
+	hash.Low = h1;
+	hash.High = h2;
+	return hash;
+}
+
+CContentHash::THash128 CContentHash::Combine(const THash128& hash, const void* data, size_t length)
+{
+	THash128 next = Calc(data, length, hash.Low ^ Rotl(hash.High, 17));
+	next.High ^= hash.High;
+	return next;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+/** Fast non-cryptographic 128 bit content hash (MurmurHash3 x64/128 scheme). Used to detect unchanged blocks between two runs. */
+class CContentHash
+{
+public:
+	struct THash128
+	{
+		uint64_t Low;
+		uint64_t High;
+		bool operator==(const THash128& other) const { return Low == other.Low && High == other.High; }
+		bool operator!=(const THash128& other) const { return !(*this == other); }
+		bool operator<(const THash128& other) const { return High < other.High || (High == other.High && Low < other.Low); }
+	};
+
+	static THash128 Calc(const void* data, size_t length, uint64_t seed = 0);
+	/** chains a further buffer into an existing hash (order dependent) */
+	static THash128 Combine(const THash128& hash, const void* data, size_t length);
+
+private:
+	static uint64_t Rotl(uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+	static uint64_t Mix(uint64_t value);
+	static uint64_t Load64(const uint8_t* p);
+};
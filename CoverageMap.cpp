@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <bit>
+#include "CoverageMap.h"
+
+static const size_t WordBits = 64;
+
+/** sets the bits [first, last) with whole words */
+static void SetBits(std::vector<uint64_t>& bits, size_t first, size_t last)
+{
+	if (first < last)
+	{
+		const size_t firstword = first / WordBits;
+		const size_t lastword = (last - 1) / WordBits;
+		const uint64_t firstmask = ~0ull << (first % WordBits);
+		const uint64_t lastmask = ~0ull >> (WordBits - 1 - (last - 1) % WordBits);
+		if (firstword == lastword)
+		{
+			bits[firstword] |= firstmask & lastmask;
+		}
+		else
+		{
+			bits[firstword] |= firstmask;
+			std::fill(bits.begin() + firstword + 1, bits.begin() + lastword, ~0ull);
+			bits[lastword] |= lastmask;
+		}
+	}
+}
+
+CCoverageMap::CCoverageMap(uint32_t start, uint32_t length, uint32_t granularity)
+:m_u32Start(start), m_u32Length(length), m_u32Granularity(std::max<uint32_t>(granularity, 1))
+{
+	m_Granules = (static_cast<size_t>(length) + m_u32Granularity - 1) / m_u32Granularity;
+	for (auto& plane : m_Planes)
+	{
+		plane.assign((m_Granules + WordBits - 1) / WordBits, 0);
+	}
+}
+
+void CCoverageMap::Mark(EPlane plane, uint32_t start, uint32_t stop)
+{
+	const uint64_t end = static_cast<uint64_t>(m_u32Start) + m_u32Length;
+	const uint64_t first = std::max<uint64_t>(start, m_u32Start);
+	const uint64_t last = std::min<uint64_t>(stop, end);
+	if (first < last)
+	{
+		//LOADED and OVERLAPPED are rounded outward, PROTECTED and IGNORED inward - a partially protected granule is unprotected
+		//(the last granule ends at the region end, it is covered if the range reaches the region end)
+		const bool outward = (plane == LOADED) || (plane == OVERLAPPED);
+		const uint64_t granularity = m_u32Granularity;
+		const uint64_t firstgranule = outward ? (first - m_u32Start) / granularity : (first - m_u32Start + granularity - 1) / granularity;
+		const uint64_t lastgranule = (outward || (last == end)) ? (last - m_u32Start + granularity - 1) / granularity : (last - m_u32Start) / granularity;
+		SetBits(m_Planes[plane], static_cast<size_t>(firstgranule), static_cast<size_t>(lastgranule));
+	}
+}
+
+template<typename TWord> uint64_t CCoverageMap::CountBytes(TWord word) const
+{
+	size_t granules = 0;
+	for (size_t i = 0; i < m_Planes[LOADED].size(); ++i)
+	{
+		granules += std::popcount(word(i));
+	}
+	//the last granule may reach beyond the region
+	const bool lastincluded = (m_Granules > 0) && ((word((m_Granules - 1) / WordBits) >> ((m_Granules - 1) % WordBits)) & 1);
+	const uint64_t tail = static_cast<uint64_t>(m_Granules) * m_u32Granularity - m_u32Length;
+	return static_cast<uint64_t>(granules) * m_u32Granularity - (lastincluded ? tail : 0);
+}
+
+uint64_t CCoverageMap::GetUnprotectedWord(size_t index) const
+{
+	return m_Planes[LOADED][index] & ~m_Planes[PROTECTED][index] & ~m_Planes[IGNORED][index];
+}
+
+uint64_t CCoverageMap::Count(EPlane plane) const
+{
+	return CountBytes([&](size_t i) { return m_Planes[plane][i]; });
+}
+
+uint64_t CCoverageMap::CountLoaded(EPlane plane) const
+{
+	return CountBytes([&](size_t i) { return m_Planes[plane][i] & m_Planes[LOADED][i]; });
+}
+
+uint64_t CCoverageMap::CountUnprotected() const
+{
+	return CountBytes([&](size_t i) { return GetUnprotectedWord(i); });
+}
+
+std::vector<CCoverageMap::TGap> CCoverageMap::FindGaps() const
+{
+	std::vector<TGap> gaps;
+	const uint64_t end = static_cast<uint64_t>(m_u32Start) + m_u32Length;
+	auto add = [&](size_t first, size_t last)
+	{
+		const uint64_t start = static_cast<uint64_t>(m_u32Start) + static_cast<uint64_t>(first) * m_u32Granularity;
+		const uint64_t stop = std::min<uint64_t>(static_cast<uint64_t>(m_u32Start) + static_cast<uint64_t>(last) * m_u32Granularity, end);
+		gaps.push_back({ static_cast<uint32_t>(start), static_cast<uint32_t>(stop) });
+	};
+
+	//runs of set bits, words without a run boundary are skipped as a whole
+	bool inrun = false;
+	size_t runstart = 0;
+	for (size_t i = 0; i < m_Planes[LOADED].size(); ++i)
+	{
+		const uint64_t word = GetUnprotectedWord(i);
+		size_t bit = 0;
+		while (bit < WordBits)
+		{
+			const uint64_t rest = (inrun ? ~word : word) >> bit;
+			if (rest == 0)
+			{
+				break;
+			}
+			bit += std::countr_zero(rest);
+			if (inrun)
+			{
+				add(runstart, i * WordBits + bit);
+			}
+			else
+			{
+				runstart = i * WordBits + bit;
+			}
+			inrun = !inrun;
+		}
+	}
+	if (inrun)
+	{
+		add(runstart, m_Granules);
+	}
+
+	std::stable_sort(gaps.begin(), gaps.end(), [](const TGap& a, const TGap& b) { return (a.Stop - a.Start) > (b.Stop - b.Start); });
+	return gaps;
+}
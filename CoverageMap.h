@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+* Coverage of one target memory region as bitmaps, one bit per granule (4 bytes by default).
+*
+* Ranges are marked with whole 64 bit words. A partially covered granule counts as loaded (overlapped) but not as
+* protected (ignored), so rounding never hides unprotected bytes. Counts and gaps are evaluated word by word
+* (population count, trailing zero count), so a 32 MB region costs 128 KB per plane with 4 byte granules.
+*/
+class CCoverageMap
+{
+public:
+	enum EPlane
+	{
+		LOADED = 0,		/**< written by the stream */
+		PROTECTED,		/**< covered by a CRC table entry */
+		IGNORED,		/**< excluded from the check (ignored SDRAM window, ignored regions) */
+		OVERLAPPED,		/**< table entries dropped because later blocks overwrite them */
+		PLANES
+	};
+
+	struct TGap
+	{
+		uint32_t Start;
+		uint32_t Stop;
+	};
+
+	static const uint32_t DefaultGranularity = 4;
+
+	CCoverageMap(uint32_t start, uint32_t length, uint32_t granularity = DefaultGranularity);
+
+	/** marks [start, stop), clipped to the region; LOADED/OVERLAPPED rounded outward, PROTECTED/IGNORED inward to granules */
+	void Mark(EPlane plane, uint32_t start, uint32_t stop);
+	void MarkAll(EPlane plane) { Mark(plane, m_u32Start, m_u32Start + m_u32Length); }
+
+	/** marked bytes (granules times granularity, clipped to the region) */
+	uint64_t Count(EPlane plane) const;
+	/** marked bytes that are loaded as well */
+	uint64_t CountLoaded(EPlane plane) const;
+	/** loaded, neither protected nor ignored */
+	uint64_t CountUnprotected() const;
+	/** unprotected ranges, largest first */
+	std::vector<TGap> FindGaps() const;
+
+	uint32_t GetStart() const { return m_u32Start; }
+	uint32_t GetLength() const { return m_u32Length; }
+
+private:
+	uint64_t GetUnprotectedWord(size_t index) const;
+	/** bytes of the granules set in word(index) */
+	template<typename TWord> uint64_t CountBytes(TWord word) const;
+
+	uint32_t m_u32Start;
+	uint32_t m_u32Length;
+	uint32_t m_u32Granularity;
+	size_t	m_Granules;
+	std::vector<uint64_t> m_Planes[PLANES];
+};
@@ -28,7 +28,6 @@ Date       Author Description
 /*------------------------------------------------------------------------------------*/
 // #define FFGENPOLY  0x1021 /* CCITT-16 */
 
-
 /*------------------------------------------------------------------------------------*/
 /* TYPEDEFS AND STRUCTURES */
 /*------------------------------------------------------------------------------------*/
@@ -116,7 +115,7 @@ uint16 g_UpdateCrc(uint16 u16_Crc, uint8 u8_Databyte)
 
 
 /*------------------------------------------------------------------------------------*//**
-\brief  Calculate the Crc sum.
+\brief  Calculate the Crc sum byte by byte (reference implementation).
 
 \param[in] u16_Crc     the first crc value (initial value) 
 \param[in] u32_Len     numbers of data bytes for calculate crc16 sum 
@@ -124,7 +123,7 @@ uint16 g_UpdateCrc(uint16 u16_Crc, uint8 u8_Databyte)
 
 \return  calculated    the crc16 sum
 *//*----------------------------------------------------------------------------------*/
-uint16 g_CalcCrcSum(uint16 u16_Crc, uint32 u32_Len, const void* pv_Buf)
+uint16 g_CalcCrcSumBytewise(uint16 u16_Crc, uint32 u32_Len, const void* pv_Buf)
 {
     uint32 u32_i; 
     uint16 u16_tmp;
@@ -144,6 +143,71 @@ uint16 g_CalcCrcSum(uint16 u16_Crc, uint32 u32_Len, const void* pv_Buf)
 
 
 
+/*------------------------------------------------------------------------------------*//**
+\brief  Multiplication of two polynomials modulo the crc polynomial (0x11021).
+*//*----------------------------------------------------------------------------------*/
+static uint16 MulModPoly(uint16 u16_a, uint16 u16_b)
+{
+    uint16 u16_prod = 0u;
+    uint8 u8_bit;
+
+    for (u8_bit = 0u; u8_bit < 16u; u8_bit++)
+    {
+        /* horner scheme, msb of u16_b first */
+        u16_prod = (u16_prod & 0x8000u) ? (uint16)((uint16)(u16_prod << 1) ^ (uint16)0x1021) : (uint16)(u16_prod << 1);
+        if (u16_b & 0x8000u)
+        {
+            u16_prod ^= u16_a;
+        }
+        u16_b = (uint16)(u16_b << 1);
+    }
+    return u16_prod;
+}
+
+
+/*------------------------------------------------------------------------------------*//**
+\brief  Advance a crc over u32_Len zero bytes without touching any data:
+        crc * x^(8 * u32_Len) modulo the crc polynomial (log(u32_Len) steps).
+
+\param[in] u16_Crc     crc value
+\param[in] u32_Len     number of zero bytes
+
+\return  crc value after the zero bytes
+*//*----------------------------------------------------------------------------------*/
+uint16 g_ShiftCrc(uint16 u16_Crc, uint32 u32_Len)
+{
+    uint16 u16_pow = 0x0100u;   /* x^8 */
+    uint16 u16_fac = 0x0001u;   /* x^0 */
+
+    while (u32_Len)
+    {
+        if (u32_Len & 1u)
+        {
+            u16_fac = MulModPoly(u16_fac, u16_pow);
+        }
+        u16_pow = MulModPoly(u16_pow, u16_pow);
+        u32_Len >>= 1;
+    }
+    return MulModPoly(u16_Crc, u16_fac);
+}
+
+
+/*------------------------------------------------------------------------------------*//**
+\brief  Combine the crc of two consecutive buffers A and B:
+        g_CalcCrcSum(init, A|B) == g_CombineCrcSum(g_CalcCrcSum(init, A), g_CalcCrcSum(0, B), len(B))
+
+\param[in] u16_CrcA    crc of the first buffer (any initial value)
+\param[in] u16_CrcB    crc of the second buffer, calculated with initial value 0
+\param[in] u32_LenB    length of the second buffer
+
+\return  crc of the concatenation
+*//*----------------------------------------------------------------------------------*/
+uint16 g_CombineCrcSum(uint16 u16_CrcA, uint16 u16_CrcB, uint32 u32_LenB)
+{
+    return g_ShiftCrc(u16_CrcA, u32_LenB) ^ u16_CrcB;
+}
+
+
 /*------------------------------------------------------------------------------------*//**
 \brief  update of an existing crc16 check sum
 
@@ -174,11 +238,8 @@ uint16 g_UpdateCrcSum(const uint16 u16_oldCrc, const void * const pv_newData, co
             u16_crc = (uint16)(u16_crc << 8) ^ mau16_CrcTable[u8_idx];
         }
 
-        for(u16_cnt = 0u; u16_cnt < u16_remainingBytes; u16_cnt++)
-        {
-            u8_idx = (uint8)(u16_crc >> 8);
-            u16_crc = (uint16)(u16_crc << 8) ^ mau16_CrcTable[u8_idx];
-        }
+        /* propagation through the unchanged bytes: log(u16_remainingBytes) steps */
+        u16_crc = g_ShiftCrc(u16_crc, (uint32)u16_remainingBytes);
     }
     return (u16_crc ^ u16_oldCrc);
 }
@@ -51,7 +51,15 @@ extern const uint16 CRC16_DEFAULT_INITIAL_VALUE;
 /* GLOBAL FUNCTIONS */
 /*------------------------------------------------------------------------------------*/
 uint16 g_UpdateCrc(uint16 u16_Crc, uint8 u8_Databyte);
+uint16 g_CalcCrcSumBytewise(uint16 u16_Crc, uint32 u32_Len, const void * pv_Buf);
+/* CCrc16Ccitt instantiations of the crc engine (CrcEngine.cpp) */
 uint16 g_CalcCrcSum(uint16 u16_Crc, uint32 u32_Len, const void * pv_Buf);
+uint16 g_CalcCrcSumSlice8(uint16 u16_Crc, uint32 u32_Len, const void * pv_Buf);
+uint16 g_CalcCrcSumSlice16(uint16 u16_Crc, uint32 u32_Len, const void * pv_Buf);
+uint16 g_CalcCrcSumClmul(uint16 u16_Crc, uint32 u32_Len, const void * pv_Buf);
+int g_CrcClmulSupported(void);
+uint16 g_ShiftCrc(uint16 u16_Crc, uint32 u32_Len);
+uint16 g_CombineCrcSum(uint16 u16_CrcA, uint16 u16_CrcB, uint32 u32_LenB);
 uint16 g_UpdateCrcSum(const uint16 u16_oldCrc, const void * const pv_newData, const void * const pv_oldData, 
                       const uint16 u16_size, const uint16 u16_remainingBytes);
 uint16 g_SetCRCInitValue(uint16 u16_start);
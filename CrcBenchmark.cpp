@@ -0,0 +1,376 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include "CrcBenchmark.h"
+#include "ParallelCrc.h"
+#include "CrcUpdate.h"
+#include "CoverageMap.h"
+#include "Crc16.h"
+
+typedef uint16_t(*TCalc)(uint16_t crc, const uint8_t* data, size_t length);
+
+struct TBackend
+{
+	const char*	Name;
+	TCalc		Calc;
+};
+
+static uint16_t CalcBytewise(uint16_t crc, const uint8_t* data, size_t length)
+{
+	return g_CalcCrcSumBytewise(crc, static_cast<uint32>(length), data);
+}
+
+static uint16_t CalcDefault(uint16_t crc, const uint8_t* data, size_t length)
+{
+	return g_CalcCrcSum(crc, static_cast<uint32>(length), data);
+}
+
+static uint16_t CalcSlice8(uint16_t crc, const uint8_t* data, size_t length)
+{
+	return g_CalcCrcSumSlice8(crc, static_cast<uint32>(length), data);
+}
+
+static uint16_t CalcSlice16(uint16_t crc, const uint8_t* data, size_t length)
+{
+	return g_CalcCrcSumSlice16(crc, static_cast<uint32>(length), data);
+}
+
+static uint16_t CalcClmul(uint16_t crc, const uint8_t* data, size_t length)
+{
+	return g_CalcCrcSumClmul(crc, static_cast<uint32>(length), data);
+}
+
+/** chunks of CParallelCrc::ChunkLength on the calling thread, merged with g_CombineCrcSum */
+static uint16_t CalcChunked(uint16_t crc, const uint8_t* data, size_t length)
+{
+	std::vector<CParallelCrc::TChunk> chunks = CParallelCrc::Split(length, CParallelCrc::ChunkLength);
+	for (auto& chunk : chunks)
+	{
+		CParallelCrc::CalcChunk(data, chunk);
+	}
+	return CParallelCrc::Combine(crc, chunks);
+}
+
+static uint16_t CalcParallel(uint16_t crc, const uint8_t* data, size_t length)
+{
+	return CParallelCrc::Calc(crc, data, length);
+}
+
+/** the reference is the first entry */
+static std::vector<TBackend> GetBackends()
+{
+	std::vector<TBackend> backends =
+	{
+		{"bytewise", &CalcBytewise},
+		{"g_CalcCrcSum", &CalcDefault},
+		{"slice8", &CalcSlice8},
+		{"slice16", &CalcSlice16},
+	};
+	if (g_CrcClmulSupported() != 0)
+	{
+		backends.push_back({ "clmul", &CalcClmul });
+	}
+	else
+	{
+		std::cout << "PCLMULQDQ not supported, clmul back-end skipped." << std::endl;
+	}
+	backends.push_back({ "chunked", &CalcChunked });
+	backends.push_back({ "parallel", &CalcParallel });
+	return backends;
+}
+
+bool CCrcBenchmark::Run(size_t maxlength, uint32_t seed)
+{
+	//the buffers of the equivalence check cross the chunk boundaries of CParallelCrc (but stay below 8 MiB, bytewise is slow)
+	const size_t verifylength = std::min<size_t>(maxlength, 8 * 1024 * 1024);
+	bool retVal = Verify(verifylength, 2000, seed);
+	retVal = VerifyUpdate(std::min<size_t>(verifylength, 1024 * 1024), 2000, seed) && retVal;
+	retVal = VerifyCoverage(500, seed) && retVal;
+	Measure(maxlength);
+	return retVal;
+}
+
+bool CCrcBenchmark::Verify(size_t maxlength, uint32_t iterations, uint32_t seed)
+{
+	bool retVal = true;
+	const std::vector<TBackend> backends = GetBackends();
+	std::mt19937 random(seed);
+	std::vector<uint8_t> buffer(maxlength + 64);
+	for (auto& value : buffer)
+	{
+		value = static_cast<uint8_t>(random());
+	}
+
+	uint32_t mismatches = 0;
+	for (uint32_t i = 0; i < iterations; ++i)
+	{
+		//mostly short buffers (table/fold thresholds and tails), every 16th one up to maxlength
+		const size_t limit = (i % 16 == 15) ? maxlength : std::min<size_t>(maxlength, 4096);
+		const size_t length = static_cast<size_t>(random() % (limit + 1));
+		const size_t offset = static_cast<size_t>(random() % 64);
+		const uint16_t initial = static_cast<uint16_t>(random());
+		const uint8_t* data = buffer.data() + offset;
+
+		const uint16_t reference = backends[0].Calc(initial, data, length);
+		for (size_t b = 1; b < backends.size(); ++b)
+		{
+			const uint16_t crc = backends[b].Calc(initial, data, length);
+			if (crc != reference)
+			{
+				if (mismatches < 10)
+				{
+					std::cerr << std::hex << "CRC mismatch " << backends[b].Name << ": length 0x" << length << " offset 0x" << offset
+						<< " initial value 0x" << initial << " crc 0x" << crc << " expected 0x" << reference << std::endl;
+				}
+				++mismatches;
+				retVal = false;
+			}
+		}
+	}
+
+	std::cout << std::dec << "CRC equivalence (seed " << seed << ", " << iterations << " buffers up to " << maxlength << " bytes): "
+		<< (retVal ? "all back-ends match the reference." : "MISMATCH.") << std::endl;
+	if (!retVal)
+	{
+		std::cerr << std::dec << mismatches << " mismatches." << std::endl;
+	}
+	return retVal;
+}
+
+bool CCrcBenchmark::VerifyUpdate(size_t maxlength, uint32_t iterations, uint32_t seed)
+{
+	bool retVal = true;
+	std::mt19937 random(seed);
+	std::vector<uint8_t> block(std::max<size_t>(maxlength, 1));
+	for (auto& value : block)
+	{
+		value = static_cast<uint8_t>(random());
+	}
+	uint16_t crc = g_CalcCrcSum(CRC16_DEFAULT_INITIAL_VALUE, static_cast<uint32>(block.size()), block.data());
+
+	uint32_t mismatches = 0;
+	for (uint32_t i = 0; i < iterations; ++i)
+	{
+		//a few non overlapping modifications (up to 64 bytes, in random order) of the same block, the crc is carried over
+		const uint32_t length = static_cast<uint32_t>(block.size());
+		std::vector<uint32_t> offsets(1 + random() % 8);
+		for (auto& offset : offsets)
+		{
+			offset = random() % length;
+		}
+		std::sort(offsets.begin(), offsets.end());
+		offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+
+		std::vector<std::vector<uint8_t>> olddata(offsets.size());
+		std::vector<std::vector<uint8_t>> newdata(offsets.size());
+		std::vector<CCrcUpdate::TModification> modifications;
+		for (uint32_t m = 0; m < offsets.size(); ++m)
+		{
+			const uint32_t limit = ((m + 1 < offsets.size()) ? offsets[m + 1] : length) - offsets[m];
+			const uint32_t size = std::min<uint32_t>(limit, 1 + random() % 64);
+			olddata[m].assign(block.begin() + offsets[m], block.begin() + offsets[m] + size);
+			newdata[m].resize(size);
+			for (auto& value : newdata[m])
+			{
+				value = static_cast<uint8_t>(random());
+			}
+			modifications.push_back({ offsets[m], size, olddata[m].data(), newdata[m].data() });
+		}
+		std::shuffle(modifications.begin(), modifications.end(), random);
+
+		const bool updated = CCrcUpdate::Update(crc, length, modifications);
+		for (uint32_t m = 0; m < offsets.size(); ++m)
+		{
+			std::copy(newdata[m].begin(), newdata[m].end(), block.begin() + offsets[m]);
+		}
+		const uint16_t reference = g_CalcCrcSum(CRC16_DEFAULT_INITIAL_VALUE, length, block.data());
+		if (!updated || (crc != reference))
+		{
+			if (mismatches < 10)
+			{
+				std::cerr << std::hex << "CRC update mismatch: length 0x" << length << " modifications 0x" << offsets.size()
+					<< " crc 0x" << crc << " expected 0x" << reference << std::endl;
+			}
+			++mismatches;
+			retVal = false;
+			crc = reference;
+		}
+	}
+
+	std::cout << std::dec << "CRC update (seed " << seed << ", " << iterations << " modifications of a " << block.size() << " byte block): "
+		<< (retVal ? "matches the full calculation." : "MISMATCH.") << std::endl;
+	if (!retVal)
+	{
+		std::cerr << std::dec << mismatches << " mismatches." << std::endl;
+	}
+	return retVal;
+}
+
+bool CCrcBenchmark::VerifyCoverage(uint32_t iterations, uint32_t seed)
+{
+	bool retVal = true;
+	std::mt19937 random(seed);
+	uint32_t mismatches = 0;
+	uint32_t hidden = 0;
+	for (uint32_t i = 0; i < iterations; ++i)
+	{
+		//halfword aligned region (the length crosses the 64 granule words), boundaries at any byte
+		static const uint32_t Granularities[] = { 1, 2, 4, 8 };
+		const uint32_t granularity = Granularities[i % 4];
+		const uint32_t start = 0xFF800000u + 2 * (random() % 64);
+		const uint32_t length = 1 + random() % 2048;
+		CCoverageMap map(start, length, granularity);
+
+		//reference: one byte per granule byte, the ranges rounded as documented by Mark; exact: the bytes themselves
+		std::vector<uint8_t> loaded(length), covered(length), exactloaded(length), exactcovered(length);
+		auto mark = [&](CCoverageMap::EPlane plane, uint32_t first, uint32_t last)
+		{
+			map.Mark(plane, first, last);
+			if ((last <= first) || (last <= start) || (first >= start + length))
+			{
+				return;
+			}
+			first = std::max(first, start) - start;
+			last = std::min(last, start + length) - start;
+			for (uint32_t b = first; b < last; ++b)
+			{
+				((plane == CCoverageMap::LOADED) ? exactloaded : exactcovered)[b] = 1;
+			}
+			if (plane == CCoverageMap::LOADED)
+			{
+				first = first / granularity * granularity;
+				last = std::min((last + granularity - 1) / granularity * granularity, length);
+			}
+			else
+			{
+				first = (first + granularity - 1) / granularity * granularity;
+				last = (last == length) ? length : last / granularity * granularity;
+			}
+			for (uint32_t b = first; b < last; ++b)
+			{
+				((plane == CCoverageMap::LOADED) ? loaded : covered)[b] = 1;
+			}
+		};
+		const uint32_t ranges = 1 + random() % 16;
+		for (uint32_t r = 0; r < ranges; ++r)
+		{
+			const uint32_t first = start - 16 + random() % (length + 32);
+			const uint32_t last = first + random() % 256;
+			const CCoverageMap::EPlane plane = (r % 3 == 0) ? CCoverageMap::LOADED : ((r % 3 == 1) ? CCoverageMap::PROTECTED : CCoverageMap::IGNORED);
+			mark(plane, first, last);
+		}
+
+		uint64_t unprotected = 0;
+		std::vector<CCoverageMap::TGap> gaps;
+		for (uint32_t b = 0; b < length; ++b)
+		{
+			const bool gap = loaded[b] && !covered[b];
+			unprotected += gap ? 1 : 0;
+			if (gap && ((b == 0) || !loaded[b - 1] || covered[b - 1]))
+			{
+				gaps.push_back({ start + b, start + b + 1 });
+			}
+			else if (gap)
+			{
+				gaps.back().Stop++;
+			}
+			//an unchecked byte has to be reported
+			hidden += (exactloaded[b] && !exactcovered[b] && !gap) ? 1 : 0;
+		}
+		std::stable_sort(gaps.begin(), gaps.end(), [](const CCoverageMap::TGap& a, const CCoverageMap::TGap& b) { return (a.Stop - a.Start) > (b.Stop - b.Start); });
+
+		const std::vector<CCoverageMap::TGap> found = map.FindGaps();
+		bool equal = (map.CountUnprotected() == unprotected) && (found.size() == gaps.size());
+		for (size_t g = 0; equal && (g < gaps.size()); ++g)
+		{
+			equal = (found[g].Start == gaps[g].Start) && (found[g].Stop == gaps[g].Stop);
+		}
+		if (!equal)
+		{
+			if (mismatches < 10)
+			{
+				std::cerr << std::hex << "Coverage mismatch: region 0x" << start << " length 0x" << length << " granularity " << std::dec << granularity
+					<< " unprotected " << map.CountUnprotected() << " expected " << unprotected << ", gaps " << found.size() << " expected " << gaps.size() << std::endl;
+			}
+			++mismatches;
+			retVal = false;
+		}
+	}
+	retVal = retVal && (hidden == 0);
+
+	std::cout << std::dec << "Coverage map (seed " << seed << ", " << iterations << " regions): "
+		<< (retVal ? "matches the bytewise reference." : "MISMATCH.") << std::endl;
+	if (!retVal)
+	{
+		std::cerr << std::dec << mismatches << " mismatches, " << hidden << " unprotected bytes not reported." << std::endl;
+	}
+	return retVal;
+}
+
+void CCrcBenchmark::Measure(size_t maxlength)
+{
+	const std::vector<TBackend> backends = GetBackends();
+	std::vector<uint8_t> buffer(std::max(maxlength, MinLength));
+	std::mt19937 random(0);
+	for (auto& value : buffer)
+	{
+		value = static_cast<uint8_t>(random());
+	}
+
+	std::cout << "CRC throughput [GB/s]" << std::endl;
+	std::cout << std::left << std::setw(12) << "bytes" << std::right;
+	for (auto& backend : backends)
+	{
+		std::cout << std::setw(14) << backend.Name;
+	}
+	std::cout << "  fastest" << std::endl;
+
+	volatile uint16_t sink = 0;
+	for (size_t length = MinLength; length <= maxlength; length *= 4)
+	{
+		std::cout << std::left << std::setw(12) << length << std::right << std::fixed << std::setprecision(3);
+		double best = 0.0;
+		const char* fastest = "";
+		for (auto& backend : backends)
+		{
+			//repeat until the time is measurable (doubling batches keep the clock out of the short runs), a single run of the large buffers is enough
+			typedef std::chrono::steady_clock TClock;
+			uint64_t runs = 0;
+			uint64_t batch = 1;
+			uint16_t crc = 0;
+			const TClock::time_point start = TClock::now();
+			TClock::duration elapsed;
+			do
+			{
+				for (uint64_t i = 0; i < batch; ++i)
+				{
+					crc = backend.Calc(crc, buffer.data(), length);
+				}
+				runs += batch;
+				batch *= 2;
+				elapsed = TClock::now() - start;
+			} while (elapsed < std::chrono::milliseconds(MinDurationMs));
+			sink = crc;
+
+			const double seconds = std::chrono::duration<double>(elapsed).count();
+			const double throughput = static_cast<double>(length) * static_cast<double>(runs) / seconds / 1.0e9;
+			if (throughput > best)
+			{
+				best = throughput;
+				fastest = backend.Name;
+			}
+			std::cout << std::setw(14) << throughput;
+		}
+		std::cout << "  " << fastest << std::endl;
+		std::cout.unsetf(std::ios_base::floatfield);
+
+		if (length > maxlength / 4)
+		{
+			break;
+		}
+	}
+	(void)sink;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+/**
+* Throughput and equivalence check of the CRC16 (g_CalcCrcSum) back-ends on the current host.
+*
+* Every back-end is compared bit exact with the bytewise reference on random buffers (length, alignment and initial
+* value), the incremental update (CCrcUpdate) with a full recompute and the coverage map (CCoverageMap) of the
+* CRC report with a bytewise reference, afterwards the throughput is measured for buffer sizes from 16 bytes up to maxlength.
+*/
+class CCrcBenchmark
+{
+public:
+	/** smallest buffer of the throughput measurement, the size is quadrupled up to the maximum length */
+	static const size_t MinLength = 16;
+	/** every size is calculated repeatedly for at least this time */
+	static const unsigned MinDurationMs = 200;
+
+	/** equivalence check and throughput table, false if a back-end calculates a different crc */
+	static bool Run(size_t maxlength, uint32_t seed);
+
+	/** iterations random buffers (up to maxlength bytes) for every back-end */
+	static bool Verify(size_t maxlength, uint32_t iterations, uint32_t seed);
+	/** CCrcUpdate::Update after random in place modifications of a block against a full g_CalcCrcSum recompute */
+	static bool VerifyUpdate(size_t maxlength, uint32_t iterations, uint32_t seed);
+	/** CCoverageMap counts and gaps against a bytewise reference, random ranges with unaligned boundaries */
+	static bool VerifyCoverage(uint32_t iterations, uint32_t seed);
+	static void Measure(size_t maxlength);
+};
@@ -0,0 +1,165 @@
+#include "CrcEngine.h"
+#include "Crc16.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define CRC_CLMUL_AVAILABLE
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CRC_CLMUL_TARGET
+#else
+#include <cpuid.h>
+#define CRC_CLMUL_TARGET __attribute__((target("pclmul,ssse3")))
+#endif
+#endif
+
+#if defined(CRC_CLMUL_AVAILABLE)
+
+static const uint32_t Cpuid1EcxPclmulqdq = 1u << 1;
+static const uint32_t Cpuid1EcxSsse3 = 1u << 9;
+
+static bool CheckClmulSupport()
+{
+	uint32_t ecx = 0;
+#if defined(_MSC_VER)
+	int regs[4];
+	__cpuid(regs, 1);
+	ecx = static_cast<uint32_t>(regs[2]);
+#else
+	unsigned int eax, ebx, ecxreg, edx;
+	if (__get_cpuid(1u, &eax, &ebx, &ecxreg, &edx))
+	{
+		ecx = ecxreg;
+	}
+#endif
+	return (ecx & (Cpuid1EcxPclmulqdq | Cpuid1EcxSsse3)) == (Cpuid1EcxPclmulqdq | Cpuid1EcxSsse3);
+}
+
+/** 16 bytes as polynomial, the first byte (bit) of the stream is the most significant one */
+template <bool Reflected>
+CRC_CLMUL_TARGET static inline __m128i LoadBlock(const uint8_t* data, __m128i reverse, __m128i bitreverse)
+{
+	__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+	if (Reflected)
+	{
+		//reverse the bits of every byte: nibble wise table lookup
+		const __m128i mask = _mm_set1_epi8(0x0F);
+		const __m128i low = _mm_shuffle_epi8(bitreverse, _mm_and_si128(value, mask));
+		const __m128i high = _mm_shuffle_epi8(bitreverse, _mm_and_si128(_mm_srli_epi16(value, 4), mask));
+		value = _mm_or_si128(_mm_slli_epi16(low, 4), high);
+	}
+	return _mm_shuffle_epi8(value, reverse);
+}
+
+/** multiplies the high half with x^(n+64) and the low half with x^n, the result is congruent to value * x^n */
+CRC_CLMUL_TARGET static inline __m128i FoldBlock(__m128i value, __m128i constants)
+{
+	return _mm_xor_si128(_mm_clmulepi64_si128(value, constants, 0x11), _mm_clmulepi64_si128(value, constants, 0x00));
+}
+
+template <bool Reflected>
+CRC_CLMUL_TARGET static size_t FoldBlocks(const uint8_t* data, size_t length, uint32_t head, const TCrcFoldConstants& constants, uint8_t folded[16])
+{
+	const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	const __m128i bitreverse = _mm_set_epi8(0x0F, 0x07, 0x0B, 0x03, 0x0D, 0x05, 0x09, 0x01, 0x0E, 0x06, 0x0A, 0x02, 0x0C, 0x04, 0x08, 0x00);
+	const __m128i fold128 = _mm_set_epi64x(static_cast<long long>(constants.X192), static_cast<long long>(constants.X128));
+	const size_t count = length & ~static_cast<size_t>(15);
+
+	//the initial value is equivalent to xor-ing it into the first bits (crc with initial value 0)
+	__m128i acc = _mm_xor_si128(LoadBlock<Reflected>(data, reverse, bitreverse), _mm_set_epi32(static_cast<int>(head), 0, 0, 0));
+	data += 16;
+	length -= 16;
+
+	if (length >= 48)
+	{
+		const __m128i fold512 = _mm_set_epi64x(static_cast<long long>(constants.X576), static_cast<long long>(constants.X512));
+		__m128i acc1 = LoadBlock<Reflected>(data, reverse, bitreverse);
+		__m128i acc2 = LoadBlock<Reflected>(data + 16, reverse, bitreverse);
+		__m128i acc3 = LoadBlock<Reflected>(data + 32, reverse, bitreverse);
+		data += 48;
+		length -= 48;
+
+		while (length >= 64)
+		{
+			acc = _mm_xor_si128(FoldBlock(acc, fold512), LoadBlock<Reflected>(data, reverse, bitreverse));
+			acc1 = _mm_xor_si128(FoldBlock(acc1, fold512), LoadBlock<Reflected>(data + 16, reverse, bitreverse));
+			acc2 = _mm_xor_si128(FoldBlock(acc2, fold512), LoadBlock<Reflected>(data + 32, reverse, bitreverse));
+			acc3 = _mm_xor_si128(FoldBlock(acc3, fold512), LoadBlock<Reflected>(data + 48, reverse, bitreverse));
+			data += 64;
+			length -= 64;
+		}
+
+		acc = _mm_xor_si128(FoldBlock(acc, fold128), acc1);
+		acc = _mm_xor_si128(FoldBlock(acc, fold128), acc2);
+		acc = _mm_xor_si128(FoldBlock(acc, fold128), acc3);
+	}
+
+	while (length >= 16)
+	{
+		acc = _mm_xor_si128(FoldBlock(acc, fold128), LoadBlock<Reflected>(data, reverse, bitreverse));
+		data += 16;
+		length -= 16;
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(folded), _mm_shuffle_epi8(acc, reverse));
+	return count;
+}
+
+bool CCrcClmul::IsSupported()
+{
+	static const bool supported = CheckClmulSupport();
+	return supported;
+}
+
+size_t CCrcClmul::Fold(const uint8_t* data, size_t length, uint32_t head, const TCrcFoldConstants& constants, bool reflected, uint8_t folded[16])
+{
+	size_t retVal = 0;
+	if (length >= 16 && IsSupported())
+	{
+		retVal = reflected ? FoldBlocks<true>(data, length, head, constants, folded) : FoldBlocks<false>(data, length, head, constants, folded);
+	}
+	return retVal;
+}
+
+#else
+
+bool CCrcClmul::IsSupported()
+{
+	return false;
+}
+
+size_t CCrcClmul::Fold(const uint8_t*, size_t, uint32_t, const TCrcFoldConstants&, bool, uint8_t[16])
+{
+	return 0;
+}
+
+#endif
+
+/* crc16 functions of Crc16.h, all of them are CCrc16Ccitt (the initial value is passed by the caller) */
+
+extern "C" uint16 g_CalcCrcSum(uint16 u16_Crc, uint32 u32_Len, const void* pv_Buf)
+{
+	return pv_Buf != nullptr ? CCrc16Ccitt::End(CCrc16Ccitt::Update(CCrc16Ccitt::Begin(u16_Crc), pv_Buf, u32_Len)) : u16_Crc;
+}
+
+extern "C" uint16 g_CalcCrcSumSlice8(uint16 u16_Crc, uint32 u32_Len, const void* pv_Buf)
+{
+	return pv_Buf != nullptr ? CCrc16Ccitt::End(CCrc16Ccitt::UpdateSliced<8>(CCrc16Ccitt::Begin(u16_Crc), pv_Buf, u32_Len)) : u16_Crc;
+}
+
+extern "C" uint16 g_CalcCrcSumSlice16(uint16 u16_Crc, uint32 u32_Len, const void* pv_Buf)
+{
+	return pv_Buf != nullptr ? CCrc16Ccitt::End(CCrc16Ccitt::UpdateSliced<16>(CCrc16Ccitt::Begin(u16_Crc), pv_Buf, u32_Len)) : u16_Crc;
+}
+
+extern "C" uint16 g_CalcCrcSumClmul(uint16 u16_Crc, uint32 u32_Len, const void* pv_Buf)
+{
+	return pv_Buf != nullptr ? CCrc16Ccitt::End(CCrc16Ccitt::UpdateClmul(CCrc16Ccitt::Begin(u16_Crc), pv_Buf, u32_Len)) : u16_Crc;
+}
+
+extern "C" int g_CrcClmulSupported(void)
+{
+	return CCrcClmul::IsSupported() ? 1 : 0;
+}
@@ -0,0 +1,274 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <tuple>
+#include <utility>
+
+/** x^n modulo the crc polynomial for the carry-less multiplication folding (see CCrcClmul::Fold) */
+struct TCrcFoldConstants
+{
+	uint64_t	X128;
+	uint64_t	X192;
+	uint64_t	X512;
+	uint64_t	X576;
+};
+
+/**
+* Carry-less multiplication (PCLMULQDQ) back-end of CCrcEngine, shared by all crc flavors.
+*
+* The data is folded in 128 bit steps (four streams for long buffers) to a 128 bit value that is congruent to the data
+* modulo the polynomial, the engine reduces it with its tables. Polynomials up to 32 bits.
+*/
+class CCrcClmul
+{
+public:
+	/** processor supports PCLMULQDQ and SSSE3 (checked once) */
+	static bool IsSupported();
+
+	/**
+	* Folds the complete 16 byte blocks of data to 16 bytes (most significant byte first) with the same crc (initial value 0).
+	* head is the crc register (left aligned) that is xored into the first bits, reflected reverses the bits of every byte.
+	* Returns the number of bytes folded, 0 if length < 16 or the processor lacks the instructions.
+	*/
+	static size_t Fold(const uint8_t* data, size_t length, uint32_t head, const TCrcFoldConstants& constants, bool reflected, uint8_t folded[16]);
+};
+
+/**
+* Table driven crc (Rocksoft model) with compile time tables.
+*
+* Width 8..32 bits. The state is held in 32 bits: left aligned for normal crcs, right aligned and reflected for
+* reflected ones, so all widths share one slicing implementation. Begin/Update/End allow piecewise calculation.
+*/
+template <typename T, unsigned Width, uint32_t Poly, bool RefIn, bool RefOut, uint32_t Init, uint32_t XorOut>
+class CCrcEngine
+{
+	static_assert(Width >= 8 && Width <= 32, "crc width 8..32 bits");
+	static_assert(sizeof(T) * 8 >= Width, "crc type too small");
+
+public:
+	typedef T TValue;
+
+	/** shorter buffers are faster with the tables */
+	static const size_t ClmulMinLength = 64;
+
+	static constexpr uint32_t Reflect(uint32_t value, unsigned bits)
+	{
+		uint32_t result = 0;
+		for (unsigned i = 0; i < bits; ++i)
+		{
+			result = (result << 1) | ((value >> i) & 1u);
+		}
+		return result;
+	}
+
+	/** internal state for the crc register reg (Init if omitted) */
+	static constexpr uint32_t Begin(T reg = static_cast<T>(Init))
+	{
+		return RefIn ? Reflect(reg, Width) : static_cast<uint32_t>(reg) << Shift;
+	}
+
+	/** crc value of the state (output reflection and xor) */
+	static constexpr T End(uint32_t state)
+	{
+		const uint32_t reg = RefIn ? (RefOut ? state : Reflect(state, Width)) : (RefOut ? Reflect(state >> Shift, Width) : state >> Shift);
+		return static_cast<T>(reg ^ XorOut);
+	}
+
+	static T Calc(const void* data, size_t length)
+	{
+		return End(Update(Begin(), data, length));
+	}
+
+	/** carry-less multiplication for long buffers (if supported), slice by 16 otherwise */
+	static uint32_t Update(uint32_t state, const void* data, size_t length)
+	{
+		return (length >= ClmulMinLength && CCrcClmul::IsSupported()) ? UpdateClmul(state, data, length) : UpdateSliced<16>(state, data, length);
+	}
+
+	static uint32_t UpdateBytewise(uint32_t state, const void* data, size_t length)
+	{
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < length; ++i)
+		{
+			state = Step(state, p[i]);
+		}
+		return state;
+	}
+
+	/** Slices (4..16) bytes per iteration, the state only affects the first four bytes of a slice */
+	template <unsigned Slices>
+	static uint32_t UpdateSliced(uint32_t state, const void* data, size_t length)
+	{
+		static_assert(Slices >= 4 && Slices <= TableCount, "4..16 slices");
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		while (length >= Slices)
+		{
+			uint32_t crc;
+			if constexpr (RefIn)
+			{
+				const uint32_t c = state ^ (p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24));
+				crc = Tables[Slices - 1][c & 0xFF] ^ Tables[Slices - 2][(c >> 8) & 0xFF] ^ Tables[Slices - 3][(c >> 16) & 0xFF] ^ Tables[Slices - 4][c >> 24];
+			}
+			else
+			{
+				const uint32_t c = state ^ ((static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3]);
+				crc = Tables[Slices - 1][c >> 24] ^ Tables[Slices - 2][(c >> 16) & 0xFF] ^ Tables[Slices - 3][(c >> 8) & 0xFF] ^ Tables[Slices - 4][c & 0xFF];
+			}
+			for (unsigned i = 4; i < Slices; ++i)
+			{
+				crc ^= Tables[Slices - 1 - i][p[i]];
+			}
+			state = crc;
+			p += Slices;
+			length -= Slices;
+		}
+		return UpdateBytewise(state, p, length);
+	}
+
+	/** folding with carry-less multiplication (falls back to the tables if the processor lacks it) */
+	static uint32_t UpdateClmul(uint32_t state, const void* data, size_t length)
+	{
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		uint8_t folded[16];
+		const size_t count = CCrcClmul::Fold(p, length, RefIn ? Reflect(state, 32) : state, FoldConstants, RefIn, folded);
+		if (count > 0)
+		{
+			//crc of the folded value (normal bit order, initial value 0)
+			uint32_t reg = 0;
+			for (size_t i = 0; i < sizeof(folded); ++i)
+			{
+				reg = (reg << 8) ^ NormalTable[(reg >> 24) ^ folded[i]];
+			}
+			state = RefIn ? Reflect(reg, 32) : reg;
+		}
+		return UpdateSliced<16>(state, p + count, length - count);
+	}
+
+private:
+	static const unsigned TableCount = 16;
+	static const unsigned Shift = 32 - Width;
+	typedef std::array<std::array<uint32_t, 256>, TableCount> TTables;
+
+	static uint32_t Step(uint32_t state, uint8_t value)
+	{
+		return RefIn ? (state >> 8) ^ Tables[0][(state ^ value) & 0xFF] : (state << 8) ^ Tables[0][(state >> 24) ^ value];
+	}
+
+	/** byte wise table in normal bit order (left aligned) */
+	static constexpr std::array<uint32_t, 256> MakeNormalTable()
+	{
+		std::array<uint32_t, 256> table = {};
+		const uint32_t poly = Poly << Shift;
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			uint32_t c = i << 24;
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				c = (c & 0x80000000u) ? (c << 1) ^ poly : c << 1;
+			}
+			table[i] = c;
+		}
+		return table;
+	}
+
+	/** Tables[k][i] is the state of the byte i followed by k zero bytes (initial value 0) */
+	static constexpr TTables MakeTables()
+	{
+		TTables tables = {};
+		if (RefIn)
+		{
+			const uint32_t poly = Reflect(Poly, Width);
+			for (uint32_t i = 0; i < 256; ++i)
+			{
+				uint32_t c = i;
+				for (int bit = 0; bit < 8; ++bit)
+				{
+					c = (c & 1u) ? (c >> 1) ^ poly : c >> 1;
+				}
+				tables[0][i] = c;
+			}
+		}
+		else
+		{
+			tables[0] = MakeNormalTable();
+		}
+		for (unsigned k = 1; k < TableCount; ++k)
+		{
+			for (uint32_t i = 0; i < 256; ++i)
+			{
+				const uint32_t prev = tables[k - 1][i];
+				tables[k][i] = RefIn ? (prev >> 8) ^ tables[0][prev & 0xFF] : (prev << 8) ^ tables[0][prev >> 24];
+			}
+		}
+		return tables;
+	}
+
+	/** x^n modulo the polynomial (normal bit order, right aligned) */
+	static constexpr uint64_t XPowMod(unsigned n)
+	{
+		const uint64_t top = 1ull << Width;
+		uint64_t r = 1;
+		for (unsigned i = 0; i < n; ++i)
+		{
+			r <<= 1;
+			if (r & top)
+			{
+				r ^= top | Poly;
+			}
+		}
+		return r;
+	}
+
+	static constexpr TTables Tables = MakeTables();
+	static constexpr std::array<uint32_t, 256> NormalTable = MakeNormalTable();
+	static constexpr TCrcFoldConstants FoldConstants = { XPowMod(128), XPowMod(192), XPowMod(512), XPowMod(576) };
+};
+
+/** g_CalcCrcSum (initial value CRC16_DEFAULT_INITIAL_VALUE) */
+typedef CCrcEngine<uint16_t, 16, 0x1021, false, false, 0xFFFF, 0x0000> CCrc16Ccitt;
+typedef CCrcEngine<uint16_t, 16, 0x8005, true, true, 0xFFFF, 0x0000> CCrc16Modbus;
+typedef CCrcEngine<uint32_t, 32, 0x04C11DB7, true, true, 0xFFFFFFFF, 0xFFFFFFFF> CCrc32;
+
+/**
+* Several crcs of the same data in one pass: the data is processed in blocks that stay in the L1 cache while
+* every engine handles them.
+*/
+template <typename... TEngines>
+class CCrcSet
+{
+public:
+	static const size_t BlockLength = 8 * 1024;
+
+	CCrcSet()
+	:m_States{ TEngines::Begin()... }
+	{
+	}
+
+	void Update(const void* data, size_t length)
+	{
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		while (length > 0)
+		{
+			const size_t block = length < BlockLength ? length : BlockLength;
+			UpdateBlock(p, block, std::index_sequence_for<TEngines...>());
+			p += block;
+			length -= block;
+		}
+	}
+
+	template <size_t Index>
+	typename std::tuple_element<Index, std::tuple<TEngines...>>::type::TValue Get() const
+	{
+		return std::tuple_element<Index, std::tuple<TEngines...>>::type::End(m_States[Index]);
+	}
+
+private:
+	template <size_t... Index>
+	void UpdateBlock(const uint8_t* p, size_t length, std::index_sequence<Index...>)
+	{
+		((m_States[Index] = TEngines::Update(m_States[Index], p, length)), ...);
+	}
+
+	std::array<uint32_t, sizeof...(TEngines)> m_States;
+};
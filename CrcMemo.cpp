@@ -0,0 +1,179 @@
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <cstring>
+#include "CrcMemo.h"
+#include "Crc16.h"
+
+static const char MemoMagic[8] = { 'L', 'D', 'R', 'C', 'R', 'C', 'M', 'O' };
+
+static void AppendRaw(std::vector<uint8_t>& datavector, const void* data, size_t length)
+{
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+	datavector.insert(datavector.end(), p, p + length);
+}
+
+static bool ReadRaw(const std::vector<uint8_t>& datavector, size_t& pos, void* data, size_t length)
+{
+	bool retVal = pos + length <= datavector.size();
+	if (retVal)
+	{
+		memcpy(data, &datavector[pos], length);
+		pos += length;
+	}
+	return retVal;
+}
+
+CCrcMemo::CCrcMemo()
+:m_bVerify(false), m_u32Hits(0), m_u32Misses(0), m_u32Mismatches(0), m_u64SkippedBytes(0)
+{
+}
+
+bool CCrcMemo::Load(const std::string& filename)
+{
+	bool retVal = false;
+	std::ifstream file(filename, std::ios_base::in | std::ios_base::binary);
+	if (file.is_open())
+	{
+		std::vector<uint8_t> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		size_t pos = 0;
+		char magic[sizeof(MemoMagic)];
+		uint32_t version = 0;
+		uint16_t crc;
+
+		if (content.size() > sizeof(crc))
+		{
+			memcpy(&crc, &content[content.size() - sizeof(crc)], sizeof(crc));
+			content.resize(content.size() - sizeof(crc));
+			retVal = g_CalcCrcSum(CRC16_DEFAULT_INITIAL_VALUE, static_cast<uint32>(content.size()), content.data()) == crc;
+		}
+
+		retVal = retVal && ReadRaw(content, pos, magic, sizeof(magic)) && memcmp(magic, MemoMagic, sizeof(magic)) == 0;
+		retVal = retVal && ReadRaw(content, pos, &version, sizeof(version)) && version == FileVersion;
+
+		uint32_t entries = 0;
+		retVal = retVal && ReadRaw(content, pos, &entries, sizeof(entries));
+		for (uint32_t i = 0; retVal && i < entries; ++i)
+		{
+			THash128 key;
+			TEntry entry = { 0, 0 };
+			retVal = ReadRaw(content, pos, &key, sizeof(key)) && ReadRaw(content, pos, &entry.Crc, sizeof(entry.Crc)) && ReadRaw(content, pos, &entry.Age, sizeof(entry.Age));
+			if (retVal)
+			{
+				//this run hasn't used the entry yet
+				++entry.Age;
+				m_Entries[key] = entry;
+			}
+		}
+
+		if (retVal)
+		{
+			std::cout << std::dec << "CRC memo loaded: " << m_Entries.size() << " entries." << std::endl;
+		}
+		else
+		{
+			std::cerr << "CRC memo " << filename << " is invalid or outdated. Starting with an empty memo." << std::endl;
+			m_Entries.clear();
+		}
+	}
+	else
+	{
+		std::cout << "No CRC memo " << filename << " found. Starting with an empty memo." << std::endl;
+	}
+	return retVal;
+}
+
+bool CCrcMemo::Save(const std::string& filename) const
+{
+	bool retVal;
+	std::vector<uint8_t> content;
+	uint32_t entries = 0;
+	const uint32_t version = FileVersion;
+
+	AppendRaw(content, MemoMagic, sizeof(MemoMagic));
+	AppendRaw(content, &version, sizeof(version));
+
+	const size_t entrycount = content.size();
+	AppendRaw(content, &entries, sizeof(entries));
+	for (auto& i : m_Entries)
+	{
+		//entries of other variants are kept, unless they weren't used for MaxAge runs
+		if (i.second.Age <= MaxAge)
+		{
+			AppendRaw(content, &i.first, sizeof(i.first));
+			AppendRaw(content, &i.second.Crc, sizeof(i.second.Crc));
+			AppendRaw(content, &i.second.Age, sizeof(i.second.Age));
+			++entries;
+		}
+	}
+	memcpy(&content[entrycount], &entries, sizeof(entries));
+
+	const uint16_t crc = g_CalcCrcSum(CRC16_DEFAULT_INITIAL_VALUE, static_cast<uint32>(content.size()), content.data());
+	AppendRaw(content, &crc, sizeof(crc));
+
+	std::ofstream file(filename, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (file.is_open())
+	{
+		file.write(reinterpret_cast<const char*>(content.data()), content.size());
+		retVal = file.good();
+	}
+	else
+	{
+		retVal = false;
+	}
+
+	if (!retVal)
+	{
+		std::cerr << "Unable to write CRC memo " << filename << std::endl;
+	}
+	return retVal;
+}
+
+bool CCrcMemo::Find(const THash128& key, uint32_t length, uint16_t& crc)
+{
+	bool retVal = false;
+	auto it = m_Entries.find(key);
+	if (it != m_Entries.end())
+	{
+		++m_u32Hits;
+		if (!m_bVerify)
+		{
+			it->second.Age = 0;
+			crc = it->second.Crc;
+			m_u64SkippedBytes += length;
+			retVal = true;
+		}
+	}
+	else
+	{
+		++m_u32Misses;
+	}
+	return retVal;
+}
+
+void CCrcMemo::Store(const THash128& key, uint16_t crc)
+{
+	auto it = m_Entries.find(key);
+	if (it != m_Entries.end())
+	{
+		if (it->second.Crc != crc)
+		{
+			std::cerr << std::hex << "CRC memo mismatch. Memorized CRC 0x" << it->second.Crc << " computed CRC 0x" << crc << std::endl;
+			++m_u32Mismatches;
+		}
+	}
+	TEntry& entry = m_Entries[key];
+	entry.Crc = crc;
+	entry.Age = 0;
+}
+
+void CCrcMemo::PrintStatistics() const
+{
+	std::cout << std::dec << "CRC memo" << (m_bVerify ? " (verification)" : "") << ": " << m_u32Hits << " hits/" << m_u32Misses << " misses, "
+		<< m_u64SkippedBytes << " bytes not recalculated, " << m_Entries.size() << " entries." << std::endl;
+	if (m_bVerify)
+	{
+		std::cout << std::dec << "CRC memo verification: " << m_u32Mismatches << " mismatches." << std::endl;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <map>
+#include "ContentHash.h"
+
+/**
+* Persistent CRC16 memo keyed by the content hash (bytes, length and initial value) of a memory block.
+*
+* Unlike the CRCs of CPatchCache the memo is not bound to one project: entries that were not used by a run are
+* kept for MaxAge further runs, so the blocks shared by product variants (libraries, ROM tables, constant data)
+* are found no matter which variant was built last.
+*/
+class CCrcMemo
+{
+public:
+	typedef CContentHash::THash128 THash128;
+
+	/** runs an unused entry survives */
+	static const uint16_t MaxAge = 32;
+
+	CCrcMemo();
+
+	bool Load(const std::string& filename);
+	bool Save(const std::string& filename) const;
+
+	/** verification mode: memorized CRCs are recomputed and compared instead of being reused */
+	void SetVerification(bool verify) { m_bVerify = verify; }
+
+	/** length of the block for the statistics */
+	bool Find(const THash128& key, uint32_t length, uint16_t& crc);
+	void Store(const THash128& key, uint16_t crc);
+
+	bool IsConsistent() const { return m_u32Mismatches == 0; }
+	void PrintStatistics() const;
+
+private:
+	static const uint32_t FileVersion = 1;
+
+	struct TEntry
+	{
+		uint16_t Crc;
+		uint16_t Age;		/**< runs since the last use (0: used by this run) */
+	};
+
+	bool	m_bVerify;
+	std::map<THash128, TEntry> m_Entries;
+	uint32_t m_u32Hits;
+	uint32_t m_u32Misses;
+	uint32_t m_u32Mismatches;
+	uint64_t m_u64SkippedBytes;
+};
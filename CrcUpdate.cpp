@@ -0,0 +1,33 @@
+#include <algorithm>
+#include "CrcUpdate.h"
+#include "Crc16.h"
+
+bool CCrcUpdate::Update(uint16_t& crc, uint32_t blocklength, std::vector<TModification> modifications)
+{
+	bool retVal = true;
+	std::sort(modifications.begin(), modifications.end(), [](const TModification& a, const TModification& b) { return a.Offset < b.Offset; });
+
+	//crc (initial value 0) of the xor difference between the first modified byte and the end of the block
+	uint16 difference = 0;
+	uint32_t position = modifications.empty() ? blocklength : modifications.front().Offset;
+	for (auto& modification : modifications)
+	{
+		if (modification.Offset < position || modification.Offset > blocklength || modification.Length > blocklength - modification.Offset)
+		{
+			retVal = false;
+			break;
+		}
+		difference = g_ShiftCrc(difference, modification.Offset - position);
+		for (uint32_t i = 0; i < modification.Length; ++i)
+		{
+			difference = g_UpdateCrc(difference, modification.OldData[i] ^ modification.NewData[i]);
+		}
+		position = modification.Offset + modification.Length;
+	}
+
+	if (retVal)
+	{
+		crc ^= g_ShiftCrc(difference, blocklength - position);
+	}
+	return retVal;
+}
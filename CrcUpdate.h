@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/**
+* Incremental update of a CRC16 (g_CalcCrcSum) after small in place modifications of the checked block.
+*
+* The CRC is linear: only the difference of old and new data is calculated and moved to the end of the block
+* with g_ShiftCrc, the unchanged bytes are never read.
+*/
+class CCrcUpdate
+{
+public:
+	struct TModification
+	{
+		uint32_t	Offset;		///< relative to the start of the block
+		uint32_t	Length;
+		const uint8_t* OldData;
+		const uint8_t* NewData;
+	};
+
+	/** false (crc unchanged) if a modification exceeds the block or modifications overlap */
+	static bool Update(uint16_t& crc, uint32_t blocklength, std::vector<TModification> modifications);
+};
@@ -0,0 +1,81 @@
+#include "DescriptorTable.h"
+
+CDescriptorTable::CDescriptorTable()
+:m_u32Address(0)
+{
+}
+
+void CDescriptorTable::Put16(uint8_t* p, uint16_t value)
+{
+	p[0] = static_cast<uint8_t>(value);
+	p[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void CDescriptorTable::Put32(uint8_t* p, uint32_t value)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		p[i] = static_cast<uint8_t>(value >> (8 * i));
+	}
+}
+
+uint16_t CDescriptorTable::Get16(const uint8_t* p)
+{
+	return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t CDescriptorTable::Get32(const uint8_t* p)
+{
+	uint32_t value = 0;
+	for (int i = 3; i >= 0; --i)
+	{
+		value = (value << 8) | p[i];
+	}
+	return value;
+}
+
+void CDescriptorTable::Build(const std::vector<TEntry>& entries, uint32_t tableaddress, uint32_t statevectoraddress)
+{
+	m_u32Address = tableaddress;
+	//padding bytes are 0
+	m_Data.assign(entries.size() * EntrySize, 0);
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		uint8_t* p = &m_Data[i * EntrySize];
+		const uint32_t next = (i + 1 < entries.size()) ? tableaddress + static_cast<uint32_t>((i + 1) * EntrySize) : tableaddress;
+		Put32(p + StartOffset, entries[i].Start);
+		Put32(p + StopOffset, entries[i].Stop);
+		Put16(p + CrcOffset, entries[i].Crc);
+		Put32(p + NextOffset, next);
+		p[DMAAccessOffset] = entries[i].DMAAccess ? 1 : 0;
+		Put32(p + CrcStateOffset, statevectoraddress + static_cast<uint32_t>(i * sizeof(uint16_t)));
+	}
+}
+
+void CDescriptorTable::Clear()
+{
+	m_u32Address = 0;
+	m_Data.clear();
+}
+
+CDescriptorTable::TEntry CDescriptorTable::GetEntry(size_t index) const
+{
+	const uint8_t* p = &m_Data[index * EntrySize];
+	TEntry entry = { Get32(p + StartOffset), Get32(p + StopOffset), Get16(p + CrcOffset), p[DMAAccessOffset] != 0 };
+	return entry;
+}
+
+uint32_t CDescriptorTable::GetStateVectorAddress() const
+{
+	return IsEmpty() ? 0 : Get32(&m_Data[CrcStateOffset]);
+}
+
+bool CDescriptorTable::SetCrc(size_t index, uint16_t crc)
+{
+	bool retVal = index < GetEntryCount();
+	if (retVal)
+	{
+		Put16(&m_Data[index * EntrySize + CrcOffset], crc);
+	}
+	return retVal;
+}
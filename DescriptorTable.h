@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+* CRC descriptor table (m_astMemDescriptor) serialized in the layout of the target.
+*
+* The target is a 32 bit little endian processor, an entry is { uint16* start; uint16* stop; uint16 crc; MemoryTable* next;
+* bool dma; uint16* crcstate; } with natural alignment (24 bytes). The table is built once after all CRCs are known,
+* the entries are linked in order and the last one points back to the first.
+*/
+class CDescriptorTable
+{
+public:
+	struct TEntry
+	{
+		uint32_t	Start;
+		uint32_t	Stop;
+		uint16_t	Crc;
+		bool		DMAAccess;
+	};
+
+	static const uint32_t EntrySize = 24;
+	static const uint32_t StartOffset = 0;
+	static const uint32_t StopOffset = 4;
+	static const uint32_t CrcOffset = 8;
+	static const uint32_t NextOffset = 12;
+	static const uint32_t DMAAccessOffset = 16;
+	static const uint32_t CrcStateOffset = 20;
+
+	CDescriptorTable();
+
+	/** the CRC state of entry i is the i-th uint16 at statevectoraddress */
+	void Build(const std::vector<TEntry>& entries, uint32_t tableaddress, uint32_t statevectoraddress);
+	void Clear();
+
+	bool IsEmpty() const { return m_Data.empty(); }
+	uint32_t GetAddress() const { return m_u32Address; }
+	size_t GetEntryCount() const { return m_Data.size() / EntrySize; }
+	const std::vector<uint8_t>& GetData() const { return m_Data; }
+
+	/** entry as serialized, index < GetEntryCount() */
+	TEntry GetEntry(size_t index) const;
+	/** CRC state of the first entry, 0 if the table is empty */
+	uint32_t GetStateVectorAddress() const;
+
+	/** changes the CRC of an entry in the serialized table */
+	bool SetCrc(size_t index, uint16_t crc);
+
+private:
+	static void Put16(uint8_t* p, uint16_t value);
+	static void Put32(uint8_t* p, uint32_t value);
+	static uint16_t Get16(const uint8_t* p);
+	static uint32_t Get32(const uint8_t* p);
+
+	uint32_t	m_u32Address;
+	std::vector<uint8_t> m_Data;
+};
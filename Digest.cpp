@@ -0,0 +1,119 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cstring>
+#include "Digest.h"
+
+CDigest::CDigest()
+:m_Sha256Digest(), m_bFinal(false), m_Length(0)
+{
+}
+
+void CDigest::Update(const void* data, size_t length)
+{
+	//blocks that stay in the L1 cache for all digests
+	static const size_t BlockLength = 8 * 1024;
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+	m_Length += length;
+	while (length > 0)
+	{
+		const size_t block = length < BlockLength ? length : BlockLength;
+		m_Crc.Update(p, block);
+		m_Sha256.Update(p, block);
+		p += block;
+		length -= block;
+	}
+}
+
+const CSha256::TDigest& CDigest::GetSha256()
+{
+	if (!m_bFinal)
+	{
+		m_Sha256Digest = m_Sha256.Final();
+		m_bFinal = true;
+	}
+	return m_Sha256Digest;
+}
+
+bool CDigest::WriteManifest(const std::string& filename, const std::string& source, std::vector<std::pair<std::string, CDigest*>> digests)
+{
+	bool retVal;
+	std::ofstream file(filename, std::ios_base::out | std::ios_base::trunc);
+	if (file.is_open())
+	{
+		file << "# digests of " << source << std::endl;
+		for (auto& digest : digests)
+		{
+			file << std::dec << digest.first << ".length=" << digest.second->GetLength() << std::endl
+				<< std::hex << std::uppercase << std::setfill('0')
+				<< digest.first << ".crc16=0x" << std::setw(4) << digest.second->GetCrc16() << std::endl
+				<< digest.first << ".crc32=0x" << std::setw(8) << digest.second->GetCrc32() << std::endl
+				<< std::nouppercase << digest.first << ".sha256=" << CSha256::ToString(digest.second->GetSha256()) << std::endl;
+		}
+		retVal = file.good();
+	}
+	else
+	{
+		retVal = false;
+	}
+
+	if (!retVal)
+	{
+		std::cerr << "Unable to write manifest " << filename << std::endl;
+	}
+	return retVal;
+}
+
+CDigestStreamBuf::CDigestStreamBuf(std::streambuf* target, bool crlf)
+:m_pTarget(target), m_bCrLf(crlf)
+{
+	//one character is kept for overflow
+	setp(m_Buffer, m_Buffer + sizeof(m_Buffer) - 1);
+}
+
+CDigestStreamBuf::~CDigestStreamBuf()
+{
+	(void)Flush();
+}
+
+CDigestStreamBuf::int_type CDigestStreamBuf::overflow(int_type ch)
+{
+	if (!traits_type::eq_int_type(ch, traits_type::eof()))
+	{
+		*pptr() = traits_type::to_char_type(ch);
+		pbump(1);
+	}
+	return Flush() ? traits_type::not_eof(ch) : traits_type::eof();
+}
+
+int CDigestStreamBuf::sync()
+{
+	//the target isn't synchronized, std::endl of every line doesn't end up in a write to the file
+	return Flush() ? 0 : -1;
+}
+
+bool CDigestStreamBuf::Forward(const char* data, size_t length)
+{
+	m_Digest.Update(data, length);
+	return m_pTarget->sputn(data, static_cast<std::streamsize>(length)) == static_cast<std::streamsize>(length);
+}
+
+bool CDigestStreamBuf::Flush()
+{
+	bool retVal = true;
+	const char* p = pbase();
+	const char* end = pptr();
+	if (m_bCrLf)
+	{
+		static const char CrLf[] = { '\r', '\n' };
+		const char* lf;
+		while (retVal && (lf = static_cast<const char*>(memchr(p, '\n', end - p))) != nullptr)
+		{
+			retVal = Forward(p, lf - p) && Forward(CrLf, sizeof(CrLf));
+			p = lf + 1;
+		}
+	}
+	retVal = retVal && Forward(p, end - p);
+	setp(m_Buffer, m_Buffer + sizeof(m_Buffer) - 1);
+	return retVal;
+}
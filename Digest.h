@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <streambuf>
+#include "CrcEngine.h"
+#include "Sha256.h"
+
+/** Release digests (CRC16 of g_CalcCrcSum, CRC-32, SHA-256) of a byte stream, all of them in one pass. */
+class CDigest
+{
+public:
+	CDigest();
+
+	void Update(const void* data, size_t length);
+
+	uint64_t GetLength() const { return m_Length; }
+	uint16_t GetCrc16() const { return m_Crc.Get<0>(); }
+	uint32_t GetCrc32() const { return m_Crc.Get<1>(); }
+	/** finalizes the SHA-256 (no further updates) */
+	const CSha256::TDigest& GetSha256();
+
+	/** writes name.length/crc16/crc32/sha256 lines for every digest */
+	static bool WriteManifest(const std::string& filename, const std::string& source, std::vector<std::pair<std::string, CDigest*>> digests);
+
+private:
+	CCrcSet<CCrc16Ccitt, CCrc32> m_Crc;
+	CSha256		m_Sha256;
+	CSha256::TDigest m_Sha256Digest;
+	bool		m_bFinal;
+	uint64_t	m_Length;
+};
+
+/**
+* Output stream buffer that forwards the text to another stream buffer and calculates its digests on the way.
+*
+* The target has to be opened in binary mode: the line end translation is done here (crlf), so the digests cover
+* exactly the bytes written to the file.
+*/
+class CDigestStreamBuf : public std::streambuf
+{
+public:
+#if defined(_WIN32)
+	static const bool NativeCrLf = true;
+#else
+	static const bool NativeCrLf = false;
+#endif
+
+	CDigestStreamBuf(std::streambuf* target, bool crlf);
+	virtual ~CDigestStreamBuf();
+
+	CDigest& GetDigest() { return m_Digest; }
+
+protected:
+	virtual int_type overflow(int_type ch);
+	virtual int sync();
+
+private:
+	bool Forward(const char* data, size_t length);
+	bool Flush();
+
+	std::streambuf* m_pTarget;
+	bool		m_bCrLf;
+	CDigest		m_Digest;
+	char		m_Buffer[4096];
+};
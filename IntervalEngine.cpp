@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <queue>
+#include "IntervalEngine.h"
+
+/** the length in units is 0 (like the difference of two table pointers) */
+static bool IsEmpty(const CIntervalEngine::TInterval& block, uint32_t unit)
+{
+	const int64_t length = static_cast<int64_t>(block.Stop) - static_cast<int64_t>(block.Start);
+	return length / static_cast<int64_t>(unit) == 0;
+}
+
+/** decision of the pairwise comparison: block a, later block b */
+static uint32_t GetOverwriteCase(const CIntervalEngine::TInterval& a, const CIntervalEngine::TInterval& b, uint32_t unit)
+{
+	uint32_t retVal = 0;
+	if (!IsEmpty(b, unit))
+	{
+		if (a.Start >= b.Start && a.Start < b.Stop)
+		{
+			retVal = 1;
+		}
+		else if (a.Stop > b.Start && a.Stop < b.Stop)
+		{
+			retVal = 2;
+		}
+		else if (a.Start < b.Start && a.Stop > b.Stop)
+		{
+			retVal = 3;
+		}
+	}
+	return retVal;
+}
+
+std::vector<uint32_t> CIntervalEngine::FindOverwrites(const std::vector<TInterval>& blocks, uint32_t unit)
+{
+	std::vector<uint32_t> cases(blocks.size(), 0);
+
+	//candidates for overwriting: the non-empty blocks by start, the reversed ones (stop < start) don't fit into the sweep
+	std::vector<size_t> sorted;
+	std::vector<size_t> reversed;
+	std::vector<size_t> order;
+	std::vector<size_t> unordered;
+	for (size_t i = 0; i < blocks.size(); ++i)
+	{
+		if (blocks[i].Start <= blocks[i].Stop)
+		{
+			order.push_back(i);
+		}
+		else
+		{
+			unordered.push_back(i);
+		}
+		if (!IsEmpty(blocks[i], unit))
+		{
+			(blocks[i].Start < blocks[i].Stop ? sorted : reversed).push_back(i);
+		}
+	}
+	auto bystart = [&](size_t a, size_t b) { return blocks[a].Start < blocks[b].Start; };
+	std::stable_sort(sorted.begin(), sorted.end(), bystart);
+	std::stable_sort(order.begin(), order.end(), bystart);
+
+	//the first (lowest index) later block that overwrites block i
+	auto check = [&](size_t i, size_t j, size_t& first)
+	{
+		if (j > i && j < first)
+		{
+			const uint32_t c = GetOverwriteCase(blocks[i], blocks[j], unit);
+			if (c != 0)
+			{
+				first = j;
+				cases[i] = c;
+			}
+		}
+	};
+
+	//a matching non-empty block starts before the block and covers its start, or starts between its start and stop
+	std::vector<size_t> active;
+	size_t next = 0;
+	for (size_t i : order)
+	{
+		const TInterval& block = blocks[i];
+		while (next < sorted.size() && blocks[sorted[next]].Start < block.Start)
+		{
+			active.push_back(sorted[next++]);
+		}
+		active.erase(std::remove_if(active.begin(), active.end(), [&](size_t j) { return blocks[j].Stop <= block.Start; }), active.end());
+
+		size_t first = blocks.size();
+		for (size_t j : active)
+		{
+			check(i, j, first);
+		}
+		for (size_t p = next; p < sorted.size() && blocks[sorted[p]].Start <= block.Stop; ++p)
+		{
+			check(i, sorted[p], first);
+		}
+		for (size_t j : reversed)
+		{
+			check(i, j, first);
+		}
+	}
+
+	//reversed blocks are compared with all later ones
+	for (size_t i : unordered)
+	{
+		size_t first = blocks.size();
+		for (size_t j = i + 1; j < blocks.size(); ++j)
+		{
+			check(i, j, first);
+		}
+	}
+	return cases;
+}
+
+std::vector<CIntervalEngine::TInterval> CIntervalEngine::FindLastWritten(const std::vector<TInterval>& blocks, const std::vector<bool>& selected)
+{
+	//elementary segments between the block boundaries, a block covering the start of a segment covers all of it
+	std::vector<uint32_t> bounds;
+	std::vector<size_t> order;
+	for (size_t i = 0; i < blocks.size(); ++i)
+	{
+		if (blocks[i].Start < blocks[i].Stop)
+		{
+			bounds.push_back(blocks[i].Start);
+			bounds.push_back(blocks[i].Stop);
+			order.push_back(i);
+		}
+	}
+	std::sort(bounds.begin(), bounds.end());
+	bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return blocks[a].Start < blocks[b].Start; });
+
+	//the active blocks by index, blocks that ended are removed once they are on top
+	std::vector<TInterval> ranges;
+	std::priority_queue<size_t> active;
+	size_t next = 0;
+	for (size_t s = 0; s + 1 < bounds.size(); ++s)
+	{
+		const uint32_t start = bounds[s];
+		while (next < order.size() && blocks[order[next]].Start <= start)
+		{
+			active.push(order[next++]);
+		}
+		while (!active.empty() && blocks[active.top()].Stop <= start)
+		{
+			active.pop();
+		}
+		if (!active.empty() && selected[active.top()])
+		{
+			if (!ranges.empty() && ranges.back().Stop == start)
+			{
+				ranges.back().Stop = bounds[s + 1];
+			}
+			else
+			{
+				ranges.push_back({ start, bounds[s + 1] });
+			}
+		}
+	}
+	return ranges;
+}
+
+CRangeIndex::CRangeIndex(const std::vector<TInterval>& ranges)
+:m_Ranges(ranges), m_bDisjoint(false)
+{
+	Build();
+}
+
+void CRangeIndex::Build()
+{
+	m_Sorted.resize(m_Ranges.size());
+	for (size_t i = 0; i < m_Sorted.size(); ++i)
+	{
+		m_Sorted[i] = i;
+	}
+	std::stable_sort(m_Sorted.begin(), m_Sorted.end(), [&](size_t a, size_t b) { return m_Ranges[a].Start < m_Ranges[b].Start; });
+
+	m_bDisjoint = true;
+	for (size_t p = 0; m_bDisjoint && p < m_Sorted.size(); ++p)
+	{
+		const TInterval& range = m_Ranges[m_Sorted[p]];
+		m_bDisjoint = (range.Start < range.Stop) && (p == 0 || m_Ranges[m_Sorted[p - 1]].Stop <= range.Start);
+	}
+}
+
+void CRangeIndex::Update(size_t index, const TInterval& range)
+{
+	if (m_Ranges[index].Start != range.Start || m_Ranges[index].Stop != range.Stop)
+	{
+		m_Ranges[index] = range;
+		Build();
+	}
+}
+
+bool CRangeIndex::Contains(const TInterval& block) const
+{
+	bool retVal = false;
+	if (m_bDisjoint && block.Start < block.Stop)
+	{
+		//only the last range starting at or before the block can contain it
+		auto it = std::upper_bound(m_Sorted.begin(), m_Sorted.end(), block.Start, [&](uint32_t start, size_t i) { return start < m_Ranges[i].Start; });
+		retVal = (it != m_Sorted.begin()) && (block.Stop <= m_Ranges[*(it - 1)].Stop);
+	}
+	else
+	{
+		for (auto& range : m_Ranges)
+		{
+			if (range.Start <= block.Start && block.Stop <= range.Stop)
+			{
+				retVal = true;
+				break;
+			}
+		}
+	}
+	return retVal;
+}
+
+size_t CRangeIndex::FindOverlap(const TInterval& block) const
+{
+	size_t retVal = NotFound;
+	if (m_bDisjoint && block.Start < block.Stop)
+	{
+		//the conditions reduce to an intersection, the intersecting ranges are consecutive
+		auto it = std::upper_bound(m_Sorted.begin(), m_Sorted.end(), block.Start, [&](uint32_t start, size_t i) { return start < m_Ranges[i].Stop; });
+		for (; it != m_Sorted.end() && m_Ranges[*it].Start < block.Stop; ++it)
+		{
+			retVal = std::min(retVal, *it);
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < m_Ranges.size(); ++i)
+		{
+			const TInterval& range = m_Ranges[i];
+			if ((range.Start <= block.Start && block.Start < range.Stop) || (range.Stop >= block.Stop && block.Stop > range.Start) || (block.Start < range.Start && block.Stop >= range.Stop))
+			{
+				retVal = i;
+				break;
+			}
+		}
+	}
+	return retVal;
+}
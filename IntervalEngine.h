@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+* Overlap decisions of the memory table (ExtractMemoryLayout) without comparing every block with every other one.
+*
+* The decisions are exactly the ones of the pairwise comparison, including its corner cases (empty blocks, blocks
+* sharing a stop address, stop < start), the engine only restricts the comparisons to the candidates that can match.
+*/
+class CIntervalEngine
+{
+public:
+	struct TInterval
+	{
+		uint32_t Start;
+		uint32_t Stop;
+	};
+
+	/**
+	* A block is overwritten by a later (higher index), non-empty (at least one unit long) block if
+	*   case 1: it starts inside the later block,
+	*   case 2: it stops inside the later block (excluding its start and stop),
+	*   case 3: it encloses the later block completely (excluding its start and stop).
+	* Returns the case of the first (lowest index) later block that overwrites a block, 0 if there is none.
+	* Blocks sorted by start, a sweep line keeps the earlier starting blocks that cover the current start.
+	*/
+	static std::vector<uint32_t> FindOverwrites(const std::vector<TInterval>& blocks, uint32_t unit = 1);
+
+	/**
+	* Address ranges whose last writer (highest index covering them) is a selected block, i.e. the final content of the
+	* memory comes from the selected blocks. The ranges are sorted and disjoint, touching ones are merged.
+	*/
+	static std::vector<TInterval> FindLastWritten(const std::vector<TInterval>& blocks, const std::vector<bool>& selected);
+};
+
+/**
+* Lookup of the layout ranges a block is assigned to (binary search).
+*
+* Ranges are looked up in list order like the linear search: if the ranges overlap each other or one of them is
+* empty/reversed, the index falls back to it.
+*/
+class CRangeIndex
+{
+public:
+	typedef CIntervalEngine::TInterval TInterval;
+	static const size_t NotFound = static_cast<size_t>(-1);
+
+	explicit CRangeIndex(const std::vector<TInterval>& ranges);
+
+	/** one range contains the block completely (start <= block start, block stop <= stop) */
+	bool Contains(const TInterval& block) const;
+
+	/**
+	* First range (list order) the block starts in, stops in (including the stop of the range) or encloses,
+	* NotFound if the block is outside all ranges.
+	*/
+	size_t FindOverlap(const TInterval& block) const;
+
+	/** the caller modified a range */
+	void Update(size_t index, const TInterval& range);
+
+private:
+	void Build();
+
+	std::vector<TInterval> m_Ranges;
+	std::vector<size_t> m_Sorted;		/**< range indices by start */
+	bool	m_bDisjoint;				/**< all ranges non-empty and disjoint: the binary search is exact */
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+/**
+* Forward cursor over the blocks of a boot stream.
+*
+* Headers and payloads are handed out as views into the stream (no copies). A block is only handed out if its
+* header and payload lie completely inside the stream, a truncated or corrupt block ends the walk (nullptr).
+* THeader has to provide usFlags and ulBlockLen; fill blocks (FillFlag) don't carry a payload.
+* Use a const THeader for read only streams.
+*/
+template <typename THeader, uint32_t FillFlag>
+class CLdrStreamCursor
+{
+public:
+	typedef typename std::conditional<std::is_const<THeader>::value, const uint8_t, uint8_t>::type TByte;
+
+	CLdrStreamCursor(TByte* stream, size_t length, size_t offset = 0)
+	:m_pStream(stream), m_Length(length), m_Offset(offset), m_Next(offset), m_pHeader(nullptr), m_bNextHeader(false)
+	{
+		//the first header is checked here, every further one is covered by the check of its predecessor
+		if ((offset <= length) && (length - offset >= sizeof(THeader)))
+		{
+			Validate();
+		}
+	}
+
+	template <typename TStream>
+	explicit CLdrStreamCursor(TStream& stream, size_t offset = 0)
+	:CLdrStreamCursor(stream.data(), stream.size(), offset)
+	{
+	}
+
+	/** header of the current block, nullptr if the stream ended or the block is truncated */
+	THeader* GetHeader() const { return m_pHeader; }
+	TByte* GetPayload() const { return m_pHeader != nullptr ? m_pStream + m_Offset + sizeof(THeader) : nullptr; }
+	uint32_t GetPayloadLength() const { return static_cast<uint32_t>(m_Next - m_Offset - sizeof(THeader)); }
+	size_t GetOffset() const { return m_Offset; }
+	size_t GetPayloadOffset() const { return m_Offset + sizeof(THeader); }
+	size_t GetNextOffset() const { return m_Next; }
+
+	/** moves to the following block and returns its header (nullptr at the end of the stream or if the block is truncated) */
+	THeader* Next()
+	{
+		if (m_pHeader != nullptr)
+		{
+			m_Offset = m_Next;
+			if (m_bNextHeader)
+			{
+				Validate();
+			}
+			else
+			{
+				m_pHeader = nullptr;
+			}
+		}
+		return m_pHeader;
+	}
+
+private:
+	/** precondition: a complete header is located at m_Offset */
+	void Validate()
+	{
+		THeader* header = reinterpret_cast<THeader*>(m_pStream + m_Offset);
+		const uint64_t payload = (header->usFlags & FillFlag) ? 0 : header->ulBlockLen;
+		const uint64_t next = static_cast<uint64_t>(m_Offset) + sizeof(THeader) + payload;
+		if (next + sizeof(THeader) <= m_Length)
+		{
+			//common case - one comparison covers the payload and the following header
+			m_pHeader = header;
+			m_Next = static_cast<size_t>(next);
+			m_bNextHeader = true;
+		}
+		else if (next <= m_Length)
+		{
+			//last block of the stream
+			m_pHeader = header;
+			m_Next = static_cast<size_t>(next);
+			m_bNextHeader = false;
+		}
+		else
+		{
+			m_pHeader = nullptr;
+			m_Next = m_Offset;
+			m_bNextHeader = false;
+		}
+	}
+
+	TByte*	m_pStream;
+	size_t	m_Length;
+	size_t	m_Offset;
+	size_t	m_Next;
+	THeader* m_pHeader;
+	bool	m_bNextHeader;
+};
@@ -0,0 +1,174 @@
+#include <bit>
+#include <cstring>
+#include "MemKernels.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define MEM_SSE2_AVAILABLE
+#include <emmintrin.h>
+#endif
+
+static const size_t StepSize = 16;
+
+bool CMemKernels::IsSimdAvailable()
+{
+#if defined(MEM_SSE2_AVAILABLE)
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool CMemKernels::Record(TMismatch& result, size_t offset, uint32_t mask, bool earlyexit)
+{
+	if (result.Count == 0)
+	{
+		result.First = offset + std::countr_zero(mask);
+	}
+	if (earlyexit)
+	{
+		result.Stop = result.First + 1;
+		result.Count = 1;
+	}
+	else
+	{
+		result.Stop = offset + 32 - std::countl_zero(mask);
+		result.Count += std::popcount(mask);
+	}
+	return earlyexit;
+}
+
+CMemKernels::TMismatch CMemKernels::Compare(const uint8_t* a, const uint8_t* b, size_t length, bool earlyexit)
+{
+	TMismatch result = { length, 0, 0 };
+	size_t i = 0;
+#if defined(MEM_SSE2_AVAILABLE)
+	for (; i + StepSize <= length; i += StepSize)
+	{
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+		const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+		const uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y))) & 0xFFFFu;
+		if (mask != 0 && Record(result, i, mask, earlyexit))
+		{
+			return result;
+		}
+	}
+#endif
+	for (; i < length; ++i)
+	{
+		if (a[i] != b[i] && Record(result, i, 1u, earlyexit))
+		{
+			return result;
+		}
+	}
+	return result;
+}
+
+CMemKernels::TMismatch CMemKernels::CompareFill(const uint8_t* data, size_t length, uint32_t pattern, bool earlyexit)
+{
+	TMismatch result = { length, 0, 0 };
+	size_t i = 0;
+#if defined(MEM_SSE2_AVAILABLE)
+	//the step size is a multiple of the pattern size, every step starts with the lowest pattern byte
+	const __m128i fill = _mm_set1_epi32(static_cast<int>(pattern));
+	for (; i + StepSize <= length; i += StepSize)
+	{
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		const uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, fill))) & 0xFFFFu;
+		if (mask != 0 && Record(result, i, mask, earlyexit))
+		{
+			return result;
+		}
+	}
+#endif
+	for (; i < length; ++i)
+	{
+		if (data[i] != static_cast<uint8_t>(pattern >> (8 * (i % sizeof(pattern)))) && Record(result, i, 1u, earlyexit))
+		{
+			return result;
+		}
+	}
+	return result;
+}
+
+size_t CMemKernels::LeadingRun(const uint8_t* data, size_t length, uint32_t pattern)
+{
+	const size_t words = length & ~(sizeof(pattern) - 1);
+	return CompareFill(data, words, pattern, true).First & ~(sizeof(pattern) - 1);
+}
+
+size_t CMemKernels::TrailingRun(const uint8_t* data, size_t length, uint32_t pattern)
+{
+	const size_t words = length & ~(sizeof(pattern) - 1);
+	size_t i = words;
+#if defined(MEM_SSE2_AVAILABLE)
+	//i stays a multiple of the pattern size, every step starts with the lowest pattern byte
+	const __m128i fill = _mm_set1_epi32(static_cast<int>(pattern));
+	for (; i >= StepSize; i -= StepSize)
+	{
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i - StepSize));
+		const uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, fill))) & 0xFFFFu;
+		if (mask != 0)
+		{
+			//the run starts behind the word holding the last mismatch
+			const size_t last = i - StepSize + 31 - std::countl_zero(mask);
+			return words - (last / sizeof(pattern) + 1) * sizeof(pattern);
+		}
+	}
+#endif
+	for (; i >= sizeof(pattern); i -= sizeof(pattern))
+	{
+		uint32_t word;
+		memcpy(&word, data + i - sizeof(pattern), sizeof(word));
+		if (word != pattern)
+		{
+			break;
+		}
+	}
+	return words - i;
+}
+
+std::vector<CMemKernels::TRun> CMemKernels::FindRuns(const uint8_t* data, size_t length, size_t minlength)
+{
+	//a run ends at a word that differs from its successor
+	std::vector<TRun> runs;
+	const size_t words = length / sizeof(uint32_t);
+	size_t start = 0;
+	auto close = [&](size_t last)
+	{
+		const size_t runlength = (last + 1 - start) * sizeof(uint32_t);
+		if (runlength >= minlength)
+		{
+			TRun run = { start * sizeof(uint32_t), runlength, 0 };
+			memcpy(&run.Pattern, data + run.Offset, sizeof(run.Pattern));
+			runs.push_back(run);
+		}
+		start = last + 1;
+	};
+	size_t k = 0;
+#if defined(MEM_SSE2_AVAILABLE)
+	//words k..k+3 against k+1..k+4, constant areas pass without a single branch taken
+	for (; k + 5 <= words; k += 4)
+	{
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + k * sizeof(uint32_t)));
+		const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + (k + 1) * sizeof(uint32_t)));
+		uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, y)))) & 0xFu;
+		while (mask != 0)
+		{
+			close(k + std::countr_zero(mask));
+			mask &= mask - 1;
+		}
+	}
+#endif
+	for (; k + 1 < words; ++k)
+	{
+		if (memcmp(data + k * sizeof(uint32_t), data + (k + 1) * sizeof(uint32_t), sizeof(uint32_t)) != 0)
+		{
+			close(k);
+		}
+	}
+	if (words > 0)
+	{
+		close(words - 1);
+	}
+	return runs;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+* Block compare kernels (SSE2, 16 bytes per step, scalar fallback).
+*
+* The result holds the first mismatching offset, the offset behind the last one and the number of mismatching bytes.
+* With earlyexit the kernel stops at the first mismatch (Stop = First + 1, Count = 1).
+* The run kernels work on whole 32 bit words, the word grid starts at the beginning of the span.
+*/
+class CMemKernels
+{
+public:
+	struct TMismatch
+	{
+		size_t	First;		/**< length if the buffers are equal */
+		size_t	Stop;		/**< behind the last mismatch, 0 if the buffers are equal */
+		size_t	Count;
+	};
+
+	struct TRun
+	{
+		size_t		Offset;
+		size_t		Length;
+		uint32_t	Pattern;
+	};
+
+	static TMismatch Compare(const uint8_t* a, const uint8_t* b, size_t length, bool earlyexit);
+	/** compares with a repeated 32 bit pattern (little endian, the data starts with the lowest pattern byte) */
+	static TMismatch CompareFill(const uint8_t* data, size_t length, uint32_t pattern, bool earlyexit);
+	/** bytes at the start of the span that repeat pattern */
+	static size_t LeadingRun(const uint8_t* data, size_t length, uint32_t pattern);
+	/** bytes at the end of the whole words of the span that repeat pattern */
+	static size_t TrailingRun(const uint8_t* data, size_t length, uint32_t pattern);
+	/** runs of a repeated word with at least minlength bytes, in order */
+	static std::vector<TRun> FindRuns(const uint8_t* data, size_t length, size_t minlength);
+	static bool IsSimdAvailable();
+
+private:
+	/** records the mismatch bits of a step at offset, true if the kernel is done (early exit) */
+	static bool Record(TMismatch& result, size_t offset, uint32_t mask, bool earlyexit);
+};
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include "ParallelCrc.h"
+#include "Crc16.h"
+
+std::vector<CParallelCrc::TChunk> CParallelCrc::Split(size_t length, size_t chunklength)
+{
+	std::vector<TChunk> chunks;
+	chunklength = std::max<size_t>(chunklength, 1);
+	chunks.reserve((length + chunklength - 1) / chunklength);
+	for (size_t offset = 0; offset < length; offset += chunklength)
+	{
+		TChunk chunk = { offset, static_cast<uint32_t>(std::min(chunklength, length - offset)), 0 };
+		chunks.push_back(chunk);
+	}
+	return chunks;
+}
+
+void CParallelCrc::CalcChunk(const uint8_t* data, TChunk& chunk)
+{
+	chunk.Crc = g_CalcCrcSum(0, chunk.Length, data + chunk.Offset);
+}
+
+uint16_t CParallelCrc::Combine(uint16_t crc, const std::vector<TChunk>& chunks)
+{
+	for (auto& chunk : chunks)
+	{
+		crc = g_CombineCrcSum(crc, chunk.Crc, chunk.Length);
+	}
+	return crc;
+}
+
+uint16_t CParallelCrc::Calc(uint16_t crc, const uint8_t* data, size_t length, unsigned threads)
+{
+	if (length < MinParallelLength || threads == 1)
+	{
+		crc = g_CalcCrcSum(crc, static_cast<uint32>(length), data);
+	}
+	else
+	{
+		std::vector<TBlock> blocks(1);
+		blocks[0].Data = data;
+		blocks[0].Length = static_cast<uint32_t>(length);
+		CalcBlocks(crc, blocks, threads);
+		crc = blocks[0].Crc;
+	}
+	return crc;
+}
+
+void CParallelCrc::CalcBlocks(uint16_t crc, std::vector<TBlock>& blocks, unsigned threads)
+{
+	//large blocks are split, otherwise a single block determines the run time
+	std::vector<std::vector<TChunk>> chunks(blocks.size());
+	std::vector<std::pair<size_t, TChunk*>> jobs;
+	for (size_t i = 0; i < blocks.size(); ++i)
+	{
+		chunks[i] = Split(blocks[i].Length, ChunkLength);
+	}
+	for (size_t i = 0; i < blocks.size(); ++i)
+	{
+		for (auto& chunk : chunks[i])
+		{
+			jobs.push_back(std::make_pair(i, &chunk));
+		}
+	}
+	std::stable_sort(jobs.begin(), jobs.end(), [](const std::pair<size_t, TChunk*>& a, const std::pair<size_t, TChunk*>& b) { return a.second->Length > b.second->Length; });
+
+	Run(jobs.size(), [&](size_t i) { CalcChunk(blocks[jobs[i].first].Data, *jobs[i].second); }, threads);
+
+	for (size_t i = 0; i < blocks.size(); ++i)
+	{
+		blocks[i].Crc = Combine(crc, chunks[i]);
+	}
+}
+
+void CParallelCrc::Run(size_t count, const std::function<void(size_t)>& job, unsigned threads)
+{
+	if (threads == 0)
+	{
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	const size_t workercount = std::min<size_t>(threads, count);
+
+	std::atomic<size_t> next(0);
+	auto worker = [&]()
+	{
+		for (size_t i = next++; i < count; i = next++)
+		{
+			job(i);
+		}
+	};
+
+	//the calling thread is one of the workers
+	std::vector<std::thread> workers;
+	workers.reserve(workercount > 0 ? workercount - 1 : 0);
+	for (size_t i = 1; i < workercount; ++i)
+	{
+		workers.emplace_back(worker);
+	}
+	worker();
+	for (auto& t : workers)
+	{
+		t.join();
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <functional>
+
+/**
+* CRC16 (g_CalcCrcSum) of large buffers, calculated in independent chunks.
+*
+* Every chunk is calculated with the initial value 0 and the chunk results are merged with g_CombineCrcSum,
+* so the chunks can be calculated in any order and on several threads.
+*/
+class CParallelCrc
+{
+public:
+	struct TChunk
+	{
+		size_t		Offset;
+		uint32_t	Length;
+		uint16_t	Crc;
+	};
+
+	struct TBlock
+	{
+		const uint8_t* Data;
+		uint32_t	Length;
+		uint16_t	Crc;
+	};
+
+	/** buffers below this length are not split, the thread start up costs more than it saves */
+	static const size_t MinParallelLength = 1024 * 1024;
+	/** unit of work when several blocks are calculated */
+	static const size_t ChunkLength = 256 * 1024;
+
+	/** splits length bytes into chunks of (at most) chunklength bytes */
+	static std::vector<TChunk> Split(size_t length, size_t chunklength);
+	static void CalcChunk(const uint8_t* data, TChunk& chunk);
+	/** crc of the complete buffer, the chunks have to cover it in order */
+	static uint16_t Combine(uint16_t crc, const std::vector<TChunk>& chunks);
+
+	/** crc of the buffer, split across threads (0 -> one per hardware thread) if it is large enough */
+	static uint16_t Calc(uint16_t crc, const uint8_t* data, size_t length, unsigned threads = 0);
+	/** crc (same initial value) of every block, the chunks of all blocks are calculated longest first */
+	static void CalcBlocks(uint16_t crc, std::vector<TBlock>& blocks, unsigned threads = 0);
+
+	/** runs job(0) .. job(count - 1) on a pool of threads (0 -> one per hardware thread), in this order of start */
+	static void Run(size_t count, const std::function<void(size_t)>& job, unsigned threads = 0);
+};
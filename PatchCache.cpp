@@ -0,0 +1,248 @@
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include "PatchCache.h"
+#include "Crc16.h"
+
+static const char CacheMagic[8] = { 'L', 'D', 'R', 'C', 'A', 'C', 'H', 'E' };
+
+static void AppendRaw(std::vector<uint8_t>& datavector, const void* data, size_t length)
+{
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+	datavector.insert(datavector.end(), p, p + length);
+}
+
+static bool ReadRaw(const std::vector<uint8_t>& datavector, size_t& pos, void* data, size_t length)
+{
+	bool retVal = pos + length <= datavector.size();
+	if (retVal)
+	{
+		memcpy(data, &datavector[pos], length);
+		pos += length;
+	}
+	return retVal;
+}
+
+CPatchCache::CPatchCache(const std::string& tag)
+:m_Tag(tag), m_bVerify(false), m_u32CrcHits(0), m_u32CrcMisses(0), m_u32SegmentHits(0), m_u32SegmentMisses(0), m_u64ReusedBytes(0), m_u32Mismatches(0)
+{
+	m_Tag.resize(TagLength, '\0');
+}
+
+bool CPatchCache::Load(const std::string& filename)
+{
+	bool retVal = false;
+	std::ifstream file(filename, std::ios_base::in | std::ios_base::binary);
+	if (file.is_open())
+	{
+		std::vector<uint8_t> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		size_t pos = 0;
+		char magic[sizeof(CacheMagic)];
+		char tag[TagLength];
+		uint32_t version = 0;
+		uint16_t crc;
+
+		if (content.size() > sizeof(crc))
+		{
+			memcpy(&crc, &content[content.size() - sizeof(crc)], sizeof(crc));
+			content.resize(content.size() - sizeof(crc));
+			retVal = g_CalcCrcSum(CRC16_DEFAULT_INITIAL_VALUE, static_cast<uint32>(content.size()), content.data()) == crc;
+		}
+
+		retVal = retVal && ReadRaw(content, pos, magic, sizeof(magic)) && memcmp(magic, CacheMagic, sizeof(magic)) == 0;
+		retVal = retVal && ReadRaw(content, pos, &version, sizeof(version)) && version == FileVersion;
+		retVal = retVal && ReadRaw(content, pos, tag, sizeof(tag)) && m_Tag.compare(0, TagLength, tag, TagLength) == 0;
+
+		uint32_t entries = 0;
+		retVal = retVal && ReadRaw(content, pos, &entries, sizeof(entries));
+		for (uint32_t i = 0; retVal && i < entries; ++i)
+		{
+			THash128 key;
+			TCrcEntry entry = { 0, false };
+			retVal = ReadRaw(content, pos, &key, sizeof(key)) && ReadRaw(content, pos, &entry.Crc, sizeof(entry.Crc));
+			if (retVal)
+			{
+				m_Crc[key] = entry;
+			}
+		}
+
+		entries = 0;
+		retVal = retVal && ReadRaw(content, pos, &entries, sizeof(entries));
+		for (uint32_t i = 0; retVal && i < entries; ++i)
+		{
+			THash128 key;
+			uint32_t length = 0;
+			retVal = ReadRaw(content, pos, &key, sizeof(key)) && ReadRaw(content, pos, &length, sizeof(length)) && pos + length <= content.size();
+			if (retVal)
+			{
+				TSegmentEntry& entry = m_Segments[key];
+				entry.Data.assign(content.begin() + pos, content.begin() + pos + length);
+				entry.Used = false;
+				pos += length;
+			}
+		}
+
+		if (retVal)
+		{
+			std::cout << std::dec << "Cache loaded: " << m_Crc.size() << " CRC entries, " << m_Segments.size() << " stream segments." << std::endl;
+		}
+		else
+		{
+			std::cerr << "Cache file " << filename << " is invalid or outdated. Starting with an empty cache." << std::endl;
+			m_Crc.clear();
+			m_Segments.clear();
+		}
+	}
+	else
+	{
+		std::cout << "No cache file " << filename << " found. Starting with an empty cache." << std::endl;
+	}
+	return retVal;
+}
+
+bool CPatchCache::Save(const std::string& filename) const
+{
+	bool retVal;
+	std::vector<uint8_t> content;
+	uint32_t entries = 0;
+	const uint32_t version = FileVersion;
+
+	AppendRaw(content, CacheMagic, sizeof(CacheMagic));
+	AppendRaw(content, &version, sizeof(version));
+	AppendRaw(content, m_Tag.data(), TagLength);
+
+	//only the entries of the current run are kept, otherwise the cache grows with every build
+	const size_t crccount = content.size();
+	AppendRaw(content, &entries, sizeof(entries));
+	for (auto& i : m_Crc)
+	{
+		if (i.second.Used)
+		{
+			AppendRaw(content, &i.first, sizeof(i.first));
+			AppendRaw(content, &i.second.Crc, sizeof(i.second.Crc));
+			++entries;
+		}
+	}
+	memcpy(&content[crccount], &entries, sizeof(entries));
+
+	entries = 0;
+	const size_t segmentcount = content.size();
+	AppendRaw(content, &entries, sizeof(entries));
+	for (auto& i : m_Segments)
+	{
+		if (i.second.Used)
+		{
+			const uint32_t length = static_cast<uint32_t>(i.second.Data.size());
+			AppendRaw(content, &i.first, sizeof(i.first));
+			AppendRaw(content, &length, sizeof(length));
+			AppendRaw(content, i.second.Data.data(), length);
+			++entries;
+		}
+	}
+	memcpy(&content[segmentcount], &entries, sizeof(entries));
+
+	const uint16_t crc = g_CalcCrcSum(CRC16_DEFAULT_INITIAL_VALUE, static_cast<uint32>(content.size()), content.data());
+	AppendRaw(content, &crc, sizeof(crc));
+
+	std::ofstream file(filename, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (file.is_open())
+	{
+		file.write(reinterpret_cast<const char*>(content.data()), content.size());
+		retVal = file.good();
+	}
+	else
+	{
+		retVal = false;
+	}
+
+	if (!retVal)
+	{
+		std::cerr << "Unable to write cache file " << filename << std::endl;
+	}
+	return retVal;
+}
+
+bool CPatchCache::FindCrc(const THash128& key, uint16_t& crc)
+{
+	bool retVal = false;
+	auto it = m_Crc.find(key);
+	if (it != m_Crc.end())
+	{
+		++m_u32CrcHits;
+		if (!m_bVerify)
+		{
+			it->second.Used = true;
+			crc = it->second.Crc;
+			retVal = true;
+		}
+	}
+	else
+	{
+		++m_u32CrcMisses;
+	}
+	return retVal;
+}
+
+void CPatchCache::StoreCrc(const THash128& key, uint16_t crc)
+{
+	auto it = m_Crc.find(key);
+	if (it != m_Crc.end())
+	{
+		if (it->second.Crc != crc)
+		{
+			std::cerr << std::hex << "Cache mismatch. Cached CRC 0x" << it->second.Crc << " computed CRC 0x" << crc << std::endl;
+			++m_u32Mismatches;
+		}
+	}
+	TCrcEntry& entry = m_Crc[key];
+	entry.Crc = crc;
+	entry.Used = true;
+}
+
+const std::vector<uint8_t>* CPatchCache::FindSegment(const THash128& key)
+{
+	const std::vector<uint8_t>* retVal = nullptr;
+	auto it = m_Segments.find(key);
+	if (it != m_Segments.end())
+	{
+		++m_u32SegmentHits;
+		if (!m_bVerify)
+		{
+			it->second.Used = true;
+			m_u64ReusedBytes += it->second.Data.size();
+			retVal = &it->second.Data;
+		}
+	}
+	else
+	{
+		++m_u32SegmentMisses;
+	}
+	return retVal;
+}
+
+void CPatchCache::StoreSegment(const THash128& key, const uint8_t* data, size_t length)
+{
+	auto it = m_Segments.find(key);
+	if (it != m_Segments.end())
+	{
+		if (it->second.Data.size() != length || (length > 0 && memcmp(it->second.Data.data(), data, length) != 0))
+		{
+			std::cerr << std::dec << "Cache mismatch. Cached stream segment (" << it->second.Data.size() << " bytes) differs from the computed one (" << length << " bytes)." << std::endl;
+			++m_u32Mismatches;
+		}
+	}
+	TSegmentEntry& entry = m_Segments[key];
+	entry.Data.assign(data, data + length);
+	entry.Used = true;
+}
+
+void CPatchCache::PrintStatistics() const
+{
+	std::cout << std::dec << "Cache" << (m_bVerify ? " (verification)" : "") << ": CRC " << m_u32CrcHits << " hits/" << m_u32CrcMisses << " misses, "
+		<< "stream segments " << m_u32SegmentHits << " hits/" << m_u32SegmentMisses << " misses, " << m_u64ReusedBytes << " bytes reused." << std::endl;
+	if (m_bVerify)
+	{
+		std::cout << std::dec << "Cache verification: " << m_u32Mismatches << " mismatches." << std::endl;
+	}
+}
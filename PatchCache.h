@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include "ContentHash.h"
+
+/** Results of a previous run (block CRCs and patched stream segments) keyed by content hashes. */
+class CPatchCache
+{
+public:
+	typedef CContentHash::THash128 THash128;
+
+	explicit CPatchCache(const std::string& tag);
+
+	bool Load(const std::string& filename);
+	bool Save(const std::string& filename) const;
+
+	/** verification mode: cached results are recomputed and compared instead of being reused */
+	void SetVerification(bool verify) { m_bVerify = verify; }
+	bool IsVerifying() const { return m_bVerify; }
+
+	bool FindCrc(const THash128& key, uint16_t& crc);
+	void StoreCrc(const THash128& key, uint16_t crc);
+	/** cached segment, valid until the segment is stored again; nullptr if unknown (or in verification mode) */
+	const std::vector<uint8_t>* FindSegment(const THash128& key);
+	void StoreSegment(const THash128& key, const uint8_t* data, size_t length);
+
+	bool IsConsistent() const { return m_u32Mismatches == 0; }
+	void PrintStatistics() const;
+
+private:
+	static const uint32_t FileVersion = 1;
+	static const size_t TagLength = 8;
+
+	struct TCrcEntry
+	{
+		uint16_t Crc;
+		bool	Used;
+	};
+
+	struct TSegmentEntry
+	{
+		std::vector<uint8_t> Data;
+		bool	Used;
+	};
+
+	std::string m_Tag;
+	bool	m_bVerify;
+	std::map<THash128, TCrcEntry> m_Crc;
+	std::map<THash128, TSegmentEntry> m_Segments;
+	uint32_t m_u32CrcHits;
+	uint32_t m_u32CrcMisses;
+	uint32_t m_u32SegmentHits;
+	uint32_t m_u32SegmentMisses;
+	uint64_t m_u64ReusedBytes;
+	uint32_t m_u32Mismatches;
+};
@@ -0,0 +1,210 @@
+#include <iostream>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+#include "PatchJournal.h"
+
+CPatchJournal::CPatchJournal(const std::vector<uint8_t>& source, size_t start)
+:m_Source(source), m_Start(std::min(start, source.size())), m_End(source.size()), m_Cursor(m_Start), m_Removed(0), m_Inserted(0), m_EditCount()
+{
+}
+
+bool CPatchJournal::BeginEdit(EEditType type, size_t offset, size_t length)
+{
+	const bool retVal = (offset >= m_Cursor) && (offset <= m_End) && (length <= m_End - offset);
+	if (retVal)
+	{
+		m_Edits.push_back({ type, offset, length, m_Pieces.size(), 0 });
+		m_Cursor = offset + length;
+		m_Removed += length;
+		m_EditCount[type]++;
+	}
+	else
+	{
+		std::cerr << std::hex << "Patch journal: edit at 0x" << offset << " is out of order." << std::endl;
+	}
+	return retVal;
+}
+
+void CPatchJournal::AppendPiece(const uint8_t* data, size_t offset, size_t length)
+{
+	//consecutive pieces of the same buffer are merged
+	TEdit& edit = m_Edits.back();
+	TPiece* last = (edit.Pieces > 0) ? &m_Pieces.back() : nullptr;
+	if ((last != nullptr) && (data != nullptr) && (last->Data != nullptr) && (last->Data + last->Length == data))
+	{
+		last->Length += length;
+	}
+	else if ((last != nullptr) && (data == nullptr) && (last->Data == nullptr) && (last->Offset + last->Length == offset))
+	{
+		last->Length += length;
+	}
+	else
+	{
+		m_Pieces.push_back({ data, offset, length });
+		edit.Pieces++;
+	}
+	m_Inserted += length;
+}
+
+void CPatchJournal::AppendView(const uint8_t* data, size_t length)
+{
+	if ((length > 0) && !m_Edits.empty())
+	{
+		AppendPiece(data, 0, length);
+	}
+}
+
+void CPatchJournal::AppendLiteral(const void* data, size_t length)
+{
+	if ((length > 0) && !m_Edits.empty())
+	{
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		const size_t offset = m_Literals.size();
+		m_Literals.insert(m_Literals.end(), p, p + length);
+		AppendPiece(nullptr, offset, length);
+	}
+}
+
+bool CPatchJournal::Overlay(EEditType type, size_t offset, const void* data, size_t length)
+{
+	//sorted by offset, overlays don't overlap
+	auto it = std::find_if(m_Overlays.begin(), m_Overlays.end(), [offset](const TOverlay& overlay) { return overlay.Offset >= offset; });
+	const bool retVal = (length > 0) && (offset + length <= GetOutputSize())
+		&& ((it == m_Overlays.end()) || (offset + length <= it->Offset))
+		&& ((it == m_Overlays.begin()) || (std::prev(it)->Offset + std::prev(it)->Length <= offset));
+	if (retVal)
+	{
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		m_Overlays.insert(it, { offset, m_Literals.size(), length });
+		m_Literals.insert(m_Literals.end(), p, p + length);
+		m_EditCount[type]++;
+	}
+	else
+	{
+		std::cerr << std::hex << "Patch journal: invalid overlay at 0x" << offset << "." << std::endl;
+	}
+	return retVal;
+}
+
+bool CPatchJournal::SetEnd(size_t offset)
+{
+	const bool retVal = (offset >= m_Cursor) && (offset <= m_Source.size());
+	if (retVal)
+	{
+		m_End = offset;
+	}
+	return retVal;
+}
+
+template<typename TVisitor> bool CPatchJournal::Walk(TVisitor visit) const
+{
+	bool retVal = true;
+	size_t cursor = m_Start;
+	for (auto it = m_Edits.begin(); retVal && (it != m_Edits.end()); ++it)
+	{
+		retVal = (it->Offset == cursor) || visit(m_Source.data() + cursor, it->Offset - cursor);
+		for (size_t i = it->FirstPiece; retVal && (i < it->FirstPiece + it->Pieces); ++i)
+		{
+			const TPiece& piece = m_Pieces[i];
+			retVal = visit((piece.Data != nullptr) ? piece.Data : m_Literals.data() + piece.Offset, piece.Length);
+		}
+		cursor = it->Offset + it->Length;
+	}
+	return retVal && ((cursor == m_End) || visit(m_Source.data() + cursor, m_End - cursor));
+}
+
+bool CPatchJournal::Read(size_t offset, void* data, size_t length) const
+{
+	uint8_t* target = static_cast<uint8_t*>(data);
+	size_t position = 0;
+	size_t copied = 0;
+	(void)Walk([&](const uint8_t* chunk, size_t chunklength)
+	{
+		const size_t from = std::max(position, offset);
+		const size_t to = std::min(position + chunklength, offset + length);
+		if (from < to)
+		{
+			memcpy(target + (from - offset), chunk + (from - position), to - from);
+			copied += to - from;
+		}
+		position += chunklength;
+		return position < offset + length;
+	});
+	return copied == length;
+}
+
+bool CPatchJournal::Apply(ISink& sink) const
+{
+	size_t position = 0;
+	size_t next = 0;
+	return Walk([&](const uint8_t* chunk, size_t length)
+	{
+		//overlays are rare (header fixes) - a chunk touched by one is written in parts
+		bool retVal = true;
+		const size_t chunkstart = position;
+		const size_t stop = position + length;
+		while (retVal && (position < stop))
+		{
+			if ((next < m_Overlays.size()) && (m_Overlays[next].Offset < stop))
+			{
+				const TOverlay& overlay = m_Overlays[next];
+				if (position < overlay.Offset)
+				{
+					retVal = sink.Write(chunk + (position - chunkstart), overlay.Offset - position);
+					position = overlay.Offset;
+				}
+				else
+				{
+					const size_t overlaystop = overlay.Offset + overlay.Length;
+					const size_t count = std::min(stop, overlaystop) - position;
+					retVal = sink.Write(m_Literals.data() + overlay.Literal + (position - overlay.Offset), count);
+					position += count;
+					next += (position == overlaystop) ? 1 : 0;
+				}
+			}
+			else
+			{
+				retVal = sink.Write(chunk + (position - chunkstart), stop - position);
+				position = stop;
+			}
+		}
+		return retVal;
+	});
+}
+
+void CPatchJournal::PrintStatistics() const
+{
+	std::cout << std::dec << "Patch journal: " << GetEditCount() << " edits ("
+		<< m_EditCount[REPLACE_RANGE] << " replaced ranges, "
+		<< m_EditCount[SPLIT_FILL_BLOCK] << " split fill blocks, "
+		<< m_EditCount[CACHED_SEGMENT] << " cached segments, "
+		<< m_EditCount[INSERT_INFO_BLOCK] << " info blocks, "
+		<< m_EditCount[FIX_DXE_ARGUMENT] << " DXE header fixes), "
+		<< GetOutputSize() << " bytes, " << m_Inserted << " bytes not copied from the source" << std::endl;
+}
+
+bool CVectorSink::Write(const uint8_t* data, size_t length)
+{
+	m_Target.insert(m_Target.end(), data, data + length);
+	return true;
+}
+
+CFileSink::CFileSink(const std::string& filename)
+:m_File(filename, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary)
+{
+}
+
+bool CFileSink::Write(const uint8_t* data, size_t length)
+{
+	m_File.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(length));
+	return m_File.good();
+}
+
+bool CFileSink::Close()
+{
+	m_File.flush();
+	const bool retVal = m_File.good();
+	m_File.close();
+	return retVal;
+}
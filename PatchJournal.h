@@ -0,0 +1,125 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+
+/**
+* Modifications of a source stream planned as an ordered journal of edits before anything is written.
+*
+* Source bytes between the edits are copied unchanged. An edit replaces a range of the source (length 0 inserts)
+* with pieces that refer to buffers staying valid until Apply (memory image, cached segments) or to generated bytes
+* kept by the journal (new headers). Overlays replace bytes of the output and are meant for fields that depend on
+* the final layout. The journal is applied to a sink, the same journal can be applied to several sinks.
+*/
+class CPatchJournal
+{
+public:
+	enum EEditType
+	{
+		REPLACE_RANGE = 0,	/**< differing bytes of a payload taken from the memory image */
+		SPLIT_FILL_BLOCK,	/**< fill block split around the CRC table */
+		CACHED_SEGMENT,		/**< patched block taken from the patch cache */
+		INSERT_INFO_BLOCK,	/**< IGNORE block carrying the application info */
+		FIX_DXE_ARGUMENT,	/**< first header of the DXE (overlay) */
+		EDIT_TYPES
+	};
+
+	class ISink
+	{
+	public:
+		virtual ~ISink() {}
+		virtual bool Write(const uint8_t* data, size_t length) = 0;
+	};
+
+	/** the journal covers the source from start up to its end (SetEnd) */
+	CPatchJournal(const std::vector<uint8_t>& source, size_t start);
+
+	/** starts an edit replacing [offset, offset + length) of the source, edits have to be added in source order */
+	bool BeginEdit(EEditType type, size_t offset, size_t length);
+	/** replacement bytes that stay valid until Apply */
+	void AppendView(const uint8_t* data, size_t length);
+	/** generated replacement bytes, copied into the journal */
+	void AppendLiteral(const void* data, size_t length);
+	/** replaces [offset, offset + length) of the output */
+	bool Overlay(EEditType type, size_t offset, const void* data, size_t length);
+	/** source bytes behind offset are dropped */
+	bool SetEnd(size_t offset);
+
+	/** output offset of a source offset behind the last edit */
+	size_t GetOutputOffset(size_t offset) const { return offset - m_Start - m_Removed + m_Inserted; }
+	size_t GetOutputSize() const { return GetOutputOffset(m_End); }
+	size_t GetEditCount(EEditType type) const { return m_EditCount[type]; }
+	size_t GetEditCount() const { return m_Edits.size() + m_Overlays.size(); }
+
+	/** planned output bytes without the overlays */
+	bool Read(size_t offset, void* data, size_t length) const;
+	bool Apply(ISink& sink) const;
+	void PrintStatistics() const;
+
+private:
+	struct TPiece
+	{
+		const uint8_t*	Data;		/**< nullptr: generated bytes at Offset */
+		size_t			Offset;
+		size_t			Length;
+	};
+
+	struct TEdit
+	{
+		EEditType	Type;
+		size_t		Offset;
+		size_t		Length;
+		size_t		FirstPiece;
+		size_t		Pieces;
+	};
+
+	struct TOverlay
+	{
+		size_t		Offset;
+		size_t		Literal;	/**< offset of the bytes in m_Literals */
+		size_t		Length;
+	};
+
+	/** hands the output out in chunks (source gaps and pieces), visit returns false to stop */
+	template<typename TVisitor> bool Walk(TVisitor visit) const;
+	void AppendPiece(const uint8_t* data, size_t offset, size_t length);
+
+	const std::vector<uint8_t>& m_Source;
+	size_t	m_Start;
+	size_t	m_End;
+	size_t	m_Cursor;		/**< behind the last edit */
+	size_t	m_Removed;
+	size_t	m_Inserted;
+	std::vector<TEdit>		m_Edits;
+	std::vector<TPiece>		m_Pieces;
+	std::vector<TOverlay>	m_Overlays;
+	std::vector<uint8_t>	m_Literals;
+	size_t	m_EditCount[EDIT_TYPES];
+};
+
+/** appends the output to a buffer */
+class CVectorSink : public CPatchJournal::ISink
+{
+public:
+	explicit CVectorSink(std::vector<uint8_t>& target) :m_Target(target) {}
+	virtual bool Write(const uint8_t* data, size_t length);
+
+private:
+	std::vector<uint8_t>& m_Target;
+};
+
+/** writes the output to a binary file */
+class CFileSink : public CPatchJournal::ISink
+{
+public:
+	explicit CFileSink(const std::string& filename);
+	bool IsOpen() const { return m_File.is_open(); }
+	virtual bool Write(const uint8_t* data, size_t length);
+	/** flushes the file, false if any write failed */
+	bool Close();
+
+private:
+	std::ofstream m_File;
+};
@@ -0,0 +1,125 @@
+#include <cstring>
+#include "Sha256.h"
+
+static const uint32_t RoundConstants[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t Rotr(uint32_t value, int count)
+{
+	return (value >> count) | (value << (32 - count));
+}
+
+CSha256::CSha256()
+:m_BlockLength(0), m_Length(0)
+{
+	static const uint32_t InitialState[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+	memcpy(m_State, InitialState, sizeof(m_State));
+}
+
+void CSha256::Transform(const uint8_t* block)
+{
+	uint32_t w[64];
+	for (int i = 0; i < 16; ++i)
+	{
+		w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) | (static_cast<uint32_t>(block[i * 4 + 1]) << 16) | (static_cast<uint32_t>(block[i * 4 + 2]) << 8) | block[i * 4 + 3];
+	}
+	for (int i = 16; i < 64; ++i)
+	{
+		const uint32_t s0 = Rotr(w[i - 15], 7) ^ Rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		const uint32_t s1 = Rotr(w[i - 2], 17) ^ Rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	uint32_t a = m_State[0], b = m_State[1], c = m_State[2], d = m_State[3];
+	uint32_t e = m_State[4], f = m_State[5], g = m_State[6], h = m_State[7];
+	for (int i = 0; i < 64; ++i)
+	{
+		const uint32_t t1 = h + (Rotr(e, 6) ^ Rotr(e, 11) ^ Rotr(e, 25)) + ((e & f) ^ (~e & g)) + RoundConstants[i] + w[i];
+		const uint32_t t2 = (Rotr(a, 2) ^ Rotr(a, 13) ^ Rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+	m_State[0] += a; m_State[1] += b; m_State[2] += c; m_State[3] += d;
+	m_State[4] += e; m_State[5] += f; m_State[6] += g; m_State[7] += h;
+}
+
+void CSha256::Update(const void* data, size_t length)
+{
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+	m_Length += length;
+	if (m_BlockLength > 0)
+	{
+		const size_t count = length < sizeof(m_Block) - m_BlockLength ? length : sizeof(m_Block) - m_BlockLength;
+		memcpy(&m_Block[m_BlockLength], p, count);
+		m_BlockLength += count;
+		p += count;
+		length -= count;
+		if (m_BlockLength == sizeof(m_Block))
+		{
+			Transform(m_Block);
+			m_BlockLength = 0;
+		}
+	}
+	//complete blocks straight from the input
+	while (length >= sizeof(m_Block))
+	{
+		Transform(p);
+		p += sizeof(m_Block);
+		length -= sizeof(m_Block);
+	}
+	if (length > 0)
+	{
+		memcpy(m_Block, p, length);
+		m_BlockLength = length;
+	}
+}
+
+CSha256::TDigest CSha256::Final()
+{
+	const uint64_t bits = m_Length * 8;
+	uint8_t padding[sizeof(m_Block) + 8] = { 0x80 };
+	const size_t padlength = (m_BlockLength < 56 ? 56 : 120) - m_BlockLength;
+	for (int i = 0; i < 8; ++i)
+	{
+		padding[padlength + i] = static_cast<uint8_t>(bits >> (56 - i * 8));
+	}
+	Update(padding, padlength + 8);
+
+	TDigest digest;
+	for (int i = 0; i < 8; ++i)
+	{
+		digest[i * 4] = static_cast<uint8_t>(m_State[i] >> 24);
+		digest[i * 4 + 1] = static_cast<uint8_t>(m_State[i] >> 16);
+		digest[i * 4 + 2] = static_cast<uint8_t>(m_State[i] >> 8);
+		digest[i * 4 + 3] = static_cast<uint8_t>(m_State[i]);
+	}
+	return digest;
+}
+
+std::string CSha256::ToString(const TDigest& digest)
+{
+	static const char Hex[] = "0123456789abcdef";
+	std::string text;
+	text.reserve(digest.size() * 2);
+	for (auto value : digest)
+	{
+		text += Hex[value >> 4];
+		text += Hex[value & 0x0F];
+	}
+	return text;
+}
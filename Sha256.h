@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <string>
+
+/** SHA-256 (FIPS 180-4), incremental. */
+class CSha256
+{
+public:
+	typedef std::array<uint8_t, 32> TDigest;
+
+	CSha256();
+
+	void Update(const void* data, size_t length);
+	/** digest of all data passed to Update (the object can't be updated afterwards) */
+	TDigest Final();
+
+	static std::string ToString(const TDigest& digest);
+
+private:
+	void Transform(const uint8_t* block);
+
+	uint32_t	m_State[8];
+	uint8_t		m_Block[64];
+	size_t		m_BlockLength;
+	uint64_t	m_Length;
+};
@@ -0,0 +1,136 @@
+#include <iostream>
+#include <fstream>
+#include "TableExporter.h"
+
+void CTableExporter::AppendHex(std::string& text, uint32_t value, int digits)
+{
+	static const char Digits[] = "0123456789ABCDEF";
+	char buffer[8];
+	int count = 0;
+	do
+	{
+		buffer[count++] = Digits[value & 0xF];
+		value >>= 4;
+	} while (value != 0 && count < 8);
+	while (count < digits)
+	{
+		buffer[count++] = '0';
+	}
+	text.append("0x");
+	while (count > 0)
+	{
+		text.push_back(buffer[--count]);
+	}
+}
+
+void CTableExporter::AppendDec(std::string& text, uint32_t value)
+{
+	char buffer[10];
+	int count = 0;
+	do
+	{
+		buffer[count++] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+	while (count > 0)
+	{
+		text.push_back(buffer[--count]);
+	}
+}
+
+std::string CTableExporter::FormatSource(const CDescriptorTable& table)
+{
+	const size_t entries = table.GetEntryCount();
+	std::string text;
+	//less than 160 characters per entry
+	text.reserve(128 + entries * 160);
+	text.append("/* m_astMemDescriptor at ");
+	AppendHex(text, table.GetAddress(), 8);
+	text.append(", ");
+	AppendDec(text, static_cast<uint32_t>(entries));
+	text.append(" entries, m_au16CRCState at ");
+	AppendHex(text, table.GetStateVectorAddress(), 8);
+	text.append(" */\n");
+	for (size_t i = 0; i < entries; ++i)
+	{
+		const CDescriptorTable::TEntry entry = table.GetEntry(i);
+		text.append("{ (uint16*)");
+		AppendHex(text, entry.Start, 8);
+		text.append(", (uint16*)");
+		AppendHex(text, entry.Stop, 8);
+		text.append(", ");
+		AppendHex(text, entry.Crc, 4);
+		text.append(", &m_astMemDescriptor[");
+		AppendHex(text, static_cast<uint32_t>((i + 1) % entries), 2);
+		text.append(entry.DMAAccess ? "], true, &m_au16CRCState[" : "], false, &m_au16CRCState[");
+		AppendHex(text, static_cast<uint32_t>(i), 2);
+		text.append(i + 1 < entries ? "]},\t/* Length=" : "]}\t/* Length=");
+		AppendHex(text, (entry.Stop - entry.Start) / sizeof(uint16_t), 1);
+		text.append("*/\n");
+	}
+	return text;
+}
+
+std::string CTableExporter::FormatJson(const CDescriptorTable& table)
+{
+	const size_t entries = table.GetEntryCount();
+	std::string text;
+	text.reserve(128 + entries * 100);
+	text.append("{\n  \"address\": ");
+	AppendDec(text, table.GetAddress());
+	text.append(",\n  \"entrysize\": ");
+	AppendDec(text, CDescriptorTable::EntrySize);
+	text.append(",\n  \"statevector\": ");
+	AppendDec(text, table.GetStateVectorAddress());
+	text.append(",\n  \"entries\": [");
+	for (size_t i = 0; i < entries; ++i)
+	{
+		const CDescriptorTable::TEntry entry = table.GetEntry(i);
+		text.append(i == 0 ? "\n    { \"start\": " : ",\n    { \"start\": ");
+		AppendDec(text, entry.Start);
+		text.append(", \"stop\": ");
+		AppendDec(text, entry.Stop);
+		text.append(", \"length\": ");
+		AppendDec(text, entry.Stop - entry.Start);
+		text.append(", \"crc\": ");
+		AppendDec(text, entry.Crc);
+		text.append(entry.DMAAccess ? ", \"dma\": true }" : ", \"dma\": false }");
+	}
+	text.append(entries > 0 ? "\n  ]\n}\n" : "]\n}\n");
+	return text;
+}
+
+bool CTableExporter::WriteFile(const std::string& filename, const char* data, size_t length)
+{
+	bool retVal = false;
+	std::ofstream file(filename, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (file.is_open())
+	{
+		file.write(data, length);
+		retVal = file.good();
+	}
+
+	if (!retVal)
+	{
+		std::cerr << "Unable to write descriptor table " << filename << std::endl;
+	}
+	return retVal;
+}
+
+bool CTableExporter::WriteSource(const CDescriptorTable& table, const std::string& filename)
+{
+	const std::string text = FormatSource(table);
+	return WriteFile(filename, text.data(), text.size());
+}
+
+bool CTableExporter::WriteBinary(const CDescriptorTable& table, const std::string& filename)
+{
+	const std::vector<uint8_t>& data = table.GetData();
+	return WriteFile(filename, reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+bool CTableExporter::WriteJson(const CDescriptorTable& table, const std::string& filename)
+{
+	const std::string text = FormatJson(table);
+	return WriteFile(filename, text.data(), text.size());
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "DescriptorTable.h"
+
+/**
+* Export of the finished CRC descriptor table (m_astMemDescriptor).
+*
+* Every format is formatted into one buffer and written with a single write, independent of the console output of
+* ExtractMemoryLayout:
+*   source: C initializer of m_astMemDescriptor, pasted into the firmware sources
+*   binary: the table in target layout (little endian, CDescriptorTable::EntrySize bytes per entry)
+*   json:   table address, state vector and the entries for CI scripts
+*/
+class CTableExporter
+{
+public:
+	static bool WriteSource(const CDescriptorTable& table, const std::string& filename);
+	static bool WriteBinary(const CDescriptorTable& table, const std::string& filename);
+	static bool WriteJson(const CDescriptorTable& table, const std::string& filename);
+
+	static std::string FormatSource(const CDescriptorTable& table);
+	static std::string FormatJson(const CDescriptorTable& table);
+
+private:
+	static void AppendHex(std::string& text, uint32_t value, int digits);
+	static void AppendDec(std::string& text, uint32_t value);
+	static bool WriteFile(const std::string& filename, const char* data, size_t length);
+};
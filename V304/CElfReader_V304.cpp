@@ -4,11 +4,19 @@
 #include <iomanip>
 #include <fstream>
 #include <vector>
+#include <algorithm>
+#include <cstddef>
 #include <stdlib.h>
 #include <sstream>
 #include <stdint.h>
 #include "CElfreader_V304.h"
 #include "..\Crc16.h"
+#include "..\LdrStreamCursor.h"
+#include "..\ParallelCrc.h"
+#include "..\CrcUpdate.h"
+#include "..\CrcEngine.h"
+#include "..\Digest.h"
+#include "..\IntervalEngine.h"
 
 #define BK_THIS_ID           0xAD
 #define BK_THIS_PROJECT      0x01
@@ -121,7 +129,7 @@ const CElfReader::TMemoryMap CElfReader::m_TemplateMemoryLayout[13] =
 
 
 CElfReader::CElfReader(std::string filename)
-:eElfStatus(UNINITIALIZED), m_StreamLength(0)
+:eElfStatus(UNINITIALIZED), m_StreamLength(0), m_bOptimizeFill(false), m_u32MinFillRun(MinFillRunLength), m_bMergeBlocks(false), m_u32MaxMergedBlock(MaxMergedBlockLength), m_u32CrcBudget(0), m_u32CrcPackEntries(0), m_bCoverageReport(false), m_bReuseHexRecords(false), m_pCache(nullptr), m_pCrcMemo(nullptr)
 {
 	memset(m_MemoryTable, 0, sizeof(m_MemoryTable));
 
@@ -292,13 +300,13 @@ const std::string& CElfReader::GetStateMessage() const
 *
 * \return None
 */
-bool CElfReader::CheckHeader(TFlashHeader *header)
+bool CElfReader::CheckHeader(const TFlashHeader *header) const
 {
 	uint32_t i;
 	uint8_t chksum = 0;
 	for (i = 0; i<sizeof(TFlashHeader); ++i)
 	{
-		chksum ^= ((uint8_t*)header)[i];
+		chksum ^= reinterpret_cast<const uint8_t*>(header)[i];
 	}
 	return !chksum;
 }
@@ -339,7 +347,8 @@ bool CElfReader::FillMemory(uint32_t address, uint32_t length, uint32_t pattern)
 	{
 		startaddress = m_MemoryLayout[i].StartAddress;
 		endaddress = m_MemoryLayout[i].StartAddress+ m_MemoryLayout[i].Length;
-		if ((address >= startaddress) && (address < endaddress))
+		//the block (rounded up to whole patterns) has to fit into the memory section
+		if ((address >= startaddress) && (address < endaddress) && (((static_cast<uint64_t>(length) + sizeof(pattern) - 1) & ~static_cast<uint64_t>(sizeof(pattern) - 1)) <= endaddress - address))
 		{
 			std::vector<uint8_t> &p = *m_MemoryLayout[i].VectorAssignment;
 			uint32_t addresscompensation = address-m_MemoryLayout[i].OffsetCompensation;
@@ -363,7 +372,7 @@ bool CElfReader::CopyBlock(uint32_t sourceaddress, uint32_t destaddress, uint32_
 	{
 		startaddress = m_MemoryLayout[i].StartAddress;
 		endaddress = m_MemoryLayout[i].StartAddress + m_MemoryLayout[i].Length;
-		if ((destaddress >= startaddress) && (destaddress < endaddress))
+		if ((destaddress >= startaddress) && (destaddress < endaddress) && (length <= endaddress - destaddress) && (static_cast<uint64_t>(sourceaddress) + length <= m_FileRawData.size()))
 		{
 			std::vector<uint8_t> &p = *m_MemoryLayout[i].VectorAssignment;
 			uint32_t addresscompensation = destaddress - m_MemoryLayout[i].OffsetCompensation;
@@ -483,14 +492,16 @@ bool CElfReader::Deflate()
 	bool retVal;
 	if (eElfStatus == ELF_OK)
 	{
-		TFlashHeader *pHdr;
-		uint32_t RawPointer = 0;
+		CLdrStreamCursor<const TFlashHeader, BFLAG_FILL> cursor(m_FileRawData);
+		const TFlashHeader *pHdr;
 		retVal = true;
 		RegeneratedMemTable.clear();
+		m_LoadedBlocks.clear();
+		m_LoadedFill.clear();
 		m_StreamLength = 0;
 		do {
-			pHdr = reinterpret_cast<TFlashHeader*>(&m_FileRawData[RawPointer]);
-			if ((((pHdr->usFlags&BK_ID) >> 24) == BK_THIS_ID) && CheckHeader(pHdr))
+			pHdr = cursor.GetHeader();
+			if ((pHdr != nullptr) && (((pHdr->usFlags&BK_ID) >> 24) == BK_THIS_ID) && CheckHeader(pHdr))
 			{
 				if (pHdr->usFlags&BFLAG_FILL)
 				{
@@ -499,22 +510,26 @@ bool CElfReader::Deflate()
 					std::cout << "Processing fill block\tAddress: 0x" << std::hex << pucAddr << "\tSize: 0x" << std::hex << ulsize << std::endl;
 
 					if (!(pHdr->usFlags&BFLAG_IGNORE))
+					{
 						FillMemory(pucAddr, ulsize, pHdr->Argument);
+						m_LoadedBlocks.push_back({ pucAddr, pucAddr + ulsize });
+						m_LoadedFill.push_back(true);
+					}
 
 					GenerateTableEntry(FILL,pucAddr, pucAddr + ulsize);
-					RawPointer += FLASHHEADER_SIZE;
 					m_StreamLength += ulsize;
 				}
 				else
 				{
 					uint32_t pucAddr = pHdr->ulRamAddr;
 
-					uint32_t RawPointerAdd = RawPointer + FLASHHEADER_SIZE;
+					uint32_t RawPointerAdd = cursor.GetPayloadOffset();
 					uint32_t ulsize = pHdr->ulBlockLen;
 					std::cout << "Processing code/data block\tAddress: 0x" << std::hex << pucAddr << "\tSize: 0x" << std::hex << ulsize << std::endl;
 					CopyBlock(RawPointerAdd, pucAddr, ulsize);
 					GenerateTableEntry(NORMAL,pucAddr, pucAddr + ulsize);
-					RawPointer += FLASHHEADER_SIZE + pHdr->ulBlockLen;
+					m_LoadedBlocks.push_back({ pucAddr, pucAddr + ulsize });
+					m_LoadedFill.push_back(false);
 					m_StreamLength += ulsize;
 				}
 
@@ -527,14 +542,19 @@ bool CElfReader::Deflate()
 				{
 					std::cout << "Another callback execution." << std::endl;
 				}
-
+				cursor.Next();
+			}
+			else if (pHdr == nullptr)
+			{
+				retVal = false;
+				std::cerr << "Truncated block at offset 0x" << std::hex << cursor.GetOffset() << std::endl;
 			}
 			else
 			{
 				retVal = false;
 				std::cerr << "Abnormal header block." << std::endl;
 			}
-		} while (((pHdr->usFlags&BFLAG_FINAL) == 0) && retVal);
+		} while (retVal && ((pHdr->usFlags&BFLAG_FINAL) == 0));
 	}
 	else
 	{
@@ -543,34 +563,43 @@ bool CElfReader::Deflate()
 	return retVal;
 }
 
-bool CElfReader::CmpFillBlock(uint32_t address, uint32_t size, uint32_t pattern)
+bool CElfReader::CmpFillBlock(uint32_t address, uint32_t size, uint32_t pattern, CMemKernels::TMismatch* mismatch, bool earlyexit)
 {
 	uint32_t startaddress, endaddress;
 	bool retVal = false;
+	//whole words are compared
+	const size_t length = static_cast<size_t>((static_cast<uint64_t>(size) + sizeof(pattern) - 1) & ~static_cast<uint64_t>(sizeof(pattern) - 1));
+	if (mismatch != nullptr)
+	{
+		*mismatch = { 0, length, length };
+	}
 	for (size_t i = 0; i < sizeof(m_MemoryLayout) / sizeof(m_MemoryLayout[0]); ++i)
 	{
 		startaddress = m_MemoryLayout[i].StartAddress;
 		endaddress = m_MemoryLayout[i].StartAddress + m_MemoryLayout[i].Length;
-		if ((address >= startaddress) && (address < endaddress))
+		if ((address >= startaddress) && (address < endaddress) && (length <= endaddress - address))
 		{
-			retVal = true;
 			std::vector<uint8_t> &p = *m_MemoryLayout[i].VectorAssignment;
 			uint32_t addresscompensation = address - m_MemoryLayout[i].OffsetCompensation;
-			for (size_t j = 0; j < size; j += sizeof(pattern))
+			const CMemKernels::TMismatch result = CMemKernels::CompareFill(p.data() + addresscompensation, length, pattern, earlyexit);
+			retVal = result.Count == 0;
+			if (mismatch != nullptr)
 			{
-				//p[addresscompensation++] = pattern;
-				retVal &= memcmp(&p[addresscompensation], &pattern, sizeof(pattern))==0;
-				addresscompensation += sizeof(pattern);
+				*mismatch = result;
 			}
 		}
 	}
 	return retVal;
 }
 
-bool CElfReader::CmpDataBlock(uint32_t address, uint32_t size, uint8_t *data)
+bool CElfReader::CmpDataBlock(uint32_t address, uint32_t size, const uint8_t *data, CMemKernels::TMismatch* mismatch, bool earlyexit)
 {
 	uint32_t startaddress, endaddress;
 	bool retVal = false;
+	if (mismatch != nullptr)
+	{
+		*mismatch = { 0, size, size };
+	}
 	for (size_t i = 0; i < sizeof(m_MemoryLayout) / sizeof(m_MemoryLayout[0]); ++i)
 	{
 		startaddress = m_MemoryLayout[i].StartAddress;
@@ -579,10 +608,11 @@ bool CElfReader::CmpDataBlock(uint32_t address, uint32_t size, uint8_t *data)
 		{
 			std::vector<uint8_t> &p = *m_MemoryLayout[i].VectorAssignment;
 			uint32_t addresscompensation = address - m_MemoryLayout[i].OffsetCompensation;
-			retVal = true;
-			for (size_t j = 0; j < size; ++j)
+			const CMemKernels::TMismatch result = CMemKernels::Compare(p.data() + addresscompensation, data, size, earlyexit);
+			retVal = result.Count == 0;
+			if (mismatch != nullptr)
 			{
-				retVal &= p[addresscompensation++] == data[j];
+				*mismatch = result;
 			}
 		}
 	}
@@ -607,18 +637,12 @@ bool CElfReader::PatchSection(std::vector<uint8_t> &datavector, TFlashHeader *he
 			std::vector<uint8_t> &p = *m_MemoryLayout[i].VectorAssignment;
 			uint32_t addresscompensation = address - m_MemoryLayout[i].OffsetCompensation;
 			retVal = true;
-			uint32_t j;
 			const uint32_t startindex = size / sizeof(pattern);
 			uint8_t *data = p.data() + addresscompensation;
-			bool nothingtochange = false;
-			for (j = startindex-1; j < startindex; --j)
-			{
-				if (reinterpret_cast<uint32_t*>(data)[j] != pattern)
-				{
-					nothingtochange = true;
-					break;
-				}
-			}
+			//j: last word that differs from the pattern
+			const size_t run = CMemKernels::TrailingRun(data, startindex * sizeof(pattern), pattern);
+			const bool nothingtochange = run < startindex * sizeof(pattern);
+			const uint32_t j = static_cast<uint32_t>((startindex * sizeof(pattern) - run) / sizeof(pattern)) - 1;
 
 			if (!nothingtochange)
 			{
@@ -649,141 +673,937 @@ bool CElfReader::PatchSection(std::vector<uint8_t> &datavector, TFlashHeader *he
 	return retVal;
 }
 
-bool CElfReader::CorrectApplicationHeaderStructure(bool appendinfoblock, uint32_t appinfoaddress, uint32_t DXEPointer)
+void CElfReader::SetFillOptimization(bool enable, uint32_t minrunlength)
+{
+	m_bOptimizeFill = enable;
+	//runs are converted word by word -> round up to a multiple of the fill pattern size
+	minrunlength = (minrunlength + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+	m_u32MinFillRun = minrunlength < MinFillRunLength ? MinFillRunLength : minrunlength;
+}
+
+void CElfReader::AppendFillHeader(std::vector<uint8_t> &datavector, TFlashHeader header, size_t &lastfill, uint32_t &mergedfills)
+{
+	if (lastfill != SIZE_MAX)
+	{
+		TFlashHeader prev;
+		memcpy(&prev, &datavector[lastfill], sizeof(TFlashHeader));
+		//same pattern, seamless and identical flags (checksum and final flag excluded)
+		if ((prev.Argument == header.Argument) && (prev.ulRamAddr + prev.ulBlockLen == header.ulRamAddr) &&
+			(((prev.usFlags ^ header.usFlags) & ~(0x00FF0000u | BFLAG_FINAL)) == 0) && !(prev.usFlags & BFLAG_FINAL))
+		{
+			prev.ulBlockLen += header.ulBlockLen;
+			prev.usFlags |= header.usFlags & BFLAG_FINAL;
+			CalcHeaderChecksum(&prev);
+			memcpy(&datavector[lastfill], &prev, sizeof(TFlashHeader));
+			++mergedfills;
+			return;
+		}
+	}
+	CalcHeaderChecksum(&header);
+	lastfill = datavector.size();
+	datavector.insert(datavector.end(), reinterpret_cast<uint8_t*>(&header), reinterpret_cast<uint8_t*>(&header) + sizeof(TFlashHeader));
+}
+
+bool CElfReader::OptimizeFillBlocks()
+{
+	bool retVal = true;
+	std::vector<uint8_t> optimized;
+	optimized.reserve(m_PatchedData.size());
+	CLdrStreamCursor<const TFlashHeader, BFLAG_FILL> cursor(m_PatchedData);
+	size_t lastfill = SIZE_MAX;	//offset of the last fill header in optimized (it may absorb the next fill block)
+	uint32_t mergedfills = 0;
+	uint32_t convertedruns = 0;
+	TFlashHeader hdr;
+
+	do {
+		if (cursor.GetHeader() == nullptr)
+		{
+			std::cerr << "Invalid data stream. Final block missing or truncated." << std::endl;
+			retVal = false;
+			break;
+		}
+		hdr = *cursor.GetHeader();
+		const uint32_t payload = cursor.GetPayloadLength();
+		const uint8_t *raw = m_PatchedData.data() + cursor.GetOffset();
+		const uint8_t *data = cursor.GetPayload();
+
+		if (hdr.usFlags & (BFLAG_FIRST | BFLAG_INIT | BFLAG_CALLBACK | BFLAG_IGNORE))
+		{
+			//blocks with side effects are kept as they are
+			optimized.insert(optimized.end(), raw, data + payload);
+			lastfill = SIZE_MAX;
+		}
+		else if (hdr.usFlags & BFLAG_FILL)
+		{
+			AppendFillHeader(optimized, hdr, lastfill, mergedfills);
+		}
+		else
+		{
+			//split code/data block at long constant runs (word aligned with respect to the target address)
+			uint32_t emitted = 0;
+			const uint32_t align = (sizeof(uint32_t) - (hdr.ulRamAddr & (sizeof(uint32_t) - 1))) & (sizeof(uint32_t) - 1);
+			const std::vector<CMemKernels::TRun> runs = (payload > align) ? CMemKernels::FindRuns(data + align, payload - align, m_u32MinFillRun) : std::vector<CMemKernels::TRun>();
+			for (auto& run : runs)
+			{
+				const uint32_t pattern = run.Pattern;
+				const uint32_t j = align + static_cast<uint32_t>(run.Offset);
+				const uint32_t k = j + static_cast<uint32_t>(run.Length);
+				if (j > emitted)
+				{
+					TFlashHeader dataheader = hdr;
+					dataheader.usFlags &= ~BFLAG_FINAL;
+					dataheader.ulRamAddr = hdr.ulRamAddr + emitted;
+					dataheader.ulBlockLen = j - emitted;
+					CalcHeaderChecksum(&dataheader);
+					optimized.insert(optimized.end(), reinterpret_cast<uint8_t*>(&dataheader), reinterpret_cast<uint8_t*>(&dataheader) + sizeof(TFlashHeader));
+					optimized.insert(optimized.end(), &data[emitted], &data[j]);
+					lastfill = SIZE_MAX;
+				}
+
+				TFlashHeader fillheader = hdr;
+				fillheader.usFlags = (hdr.usFlags & ~BFLAG_FINAL) | BFLAG_FILL;
+				fillheader.ulRamAddr = hdr.ulRamAddr + j;
+				fillheader.ulBlockLen = k - j;
+				fillheader.Argument = pattern;
+				AppendFillHeader(optimized, fillheader, lastfill, mergedfills);
+				emitted = k;
+				++convertedruns;
+			}
+
+			if (emitted == 0)
+			{
+				optimized.insert(optimized.end(), raw, data + payload);
+				lastfill = SIZE_MAX;
+			}
+			else if (emitted < payload)
+			{
+				TFlashHeader dataheader = hdr;
+				dataheader.ulRamAddr = hdr.ulRamAddr + emitted;
+				dataheader.ulBlockLen = payload - emitted;
+				CalcHeaderChecksum(&dataheader);
+				optimized.insert(optimized.end(), reinterpret_cast<uint8_t*>(&dataheader), reinterpret_cast<uint8_t*>(&dataheader) + sizeof(TFlashHeader));
+				optimized.insert(optimized.end(), &data[emitted], data + payload);
+				lastfill = SIZE_MAX;
+			}
+			else if (hdr.usFlags & BFLAG_FINAL)
+			{
+				//the block ended with a constant run -> the fill block inherits the final flag
+				TFlashHeader *pLast = reinterpret_cast<TFlashHeader*>(&optimized[lastfill]);
+				pLast->usFlags |= BFLAG_FINAL;
+				CalcHeaderChecksum(pLast);
+			}
+		}
+		cursor.Next();
+	} while (!(hdr.usFlags & BFLAG_FINAL));
+
+	if (retVal)
+	{
+		std::cout << std::dec << "Fill optimization: " << mergedfills << " fill blocks merged, " << convertedruns << " constant runs converted. Stream size "
+			<< m_PatchedData.size() << " -> " << optimized.size() << " bytes" << std::endl;
+		m_PatchedData.swap(optimized);
+	}
+	return retVal;
+}
+
+void CElfReader::SetBlockMerging(bool enable, uint32_t maxblocklength)
+{
+	m_bMergeBlocks = enable;
+	m_u32MaxMergedBlock = maxblocklength;
+}
+
+void CElfReader::SetCrcBudget(uint32_t budget)
+{
+	m_u32CrcBudget = budget;
+}
+
+void CElfReader::SetCrcPacking(uint32_t entries)
+{
+	m_u32CrcPackEntries = entries;
+}
+
+void CElfReader::SetCoverageReport(bool enable)
+{
+	m_bCoverageReport = enable;
+}
+
+void CElfReader::SetHexReuse(bool enable)
+{
+	m_bReuseHexRecords = enable;
+}
+
+int CElfReader::GetMemoryRegion(uint32_t start, uint32_t stop)const
+{
+	if (start <= stop)
+	{
+		for (size_t i = 0; i < sizeof(m_MemoryLayout) / sizeof(m_MemoryLayout[0]); ++i)
+		{
+			uint32_t startaddress = m_MemoryLayout[i].StartAddress;
+			uint32_t endaddress = m_MemoryLayout[i].StartAddress + m_MemoryLayout[i].Length;
+			if ((start >= startaddress) && (stop <= endaddress))
+			{
+				return static_cast<int>(i);
+			}
+		}
+	}
+	return -1;
+}
+
+bool CElfReader::MergeSmallBlocks()
+{
+	bool retVal = true;
+	std::vector<uint8_t> merged;
+	merged.reserve(m_PatchedData.size());
+	CLdrStreamCursor<const TFlashHeader, BFLAG_FILL> cursor(m_PatchedData);
+	size_t lastdata = SIZE_MAX;	//offset of the last code/data header in merged (it may absorb the next block)
+	int lastregion = -1;
+	uint32_t mergedblocks = 0;
+	TFlashHeader hdr;
+
+	do {
+		if (cursor.GetHeader() == nullptr)
+		{
+			std::cerr << "Invalid data stream. Final block missing or truncated." << std::endl;
+			retVal = false;
+			break;
+		}
+		hdr = *cursor.GetHeader();
+		const uint32_t payload = cursor.GetPayloadLength();
+		const uint8_t *raw = m_PatchedData.data() + cursor.GetOffset();
+		const uint8_t *data = cursor.GetPayload();
+		cursor.Next();
+
+		const bool candidate = !(hdr.usFlags & (BFLAG_FILL | BFLAG_FIRST | BFLAG_INIT | BFLAG_CALLBACK | BFLAG_IGNORE));
+		//region and dma class of the target memory have to match
+		const int region = candidate ? GetMemoryRegion(hdr.ulRamAddr, hdr.ulRamAddr + payload) : -1;
+
+		if ((lastdata != SIZE_MAX) && (region >= 0) && (region == lastregion))
+		{
+			TFlashHeader prev;
+			memcpy(&prev, &merged[lastdata], sizeof(TFlashHeader));
+			if ((prev.ulRamAddr + prev.ulBlockLen == hdr.ulRamAddr) && (prev.Argument == hdr.Argument) &&
+				(((prev.usFlags ^ hdr.usFlags) & ~(0x00FF0000u | BFLAG_FINAL)) == 0) && !(prev.usFlags & BFLAG_FINAL) &&
+				(static_cast<uint64_t>(prev.ulBlockLen) + payload <= m_u32MaxMergedBlock))
+			{
+				prev.ulBlockLen += payload;
+				prev.usFlags |= hdr.usFlags & BFLAG_FINAL;
+				CalcHeaderChecksum(&prev);
+				memcpy(&merged[lastdata], &prev, sizeof(TFlashHeader));
+				merged.insert(merged.end(), data, data + payload);
+				++mergedblocks;
+				continue;
+			}
+		}
+
+		lastdata = (region >= 0) ? merged.size() : SIZE_MAX;
+		lastregion = region;
+		merged.insert(merged.end(), raw, data + payload);
+	} while (!(hdr.usFlags & BFLAG_FINAL));
+
+	if (retVal)
+	{
+		std::cout << std::dec << "Block merging: " << mergedblocks << " blocks merged. Stream size "
+			<< m_PatchedData.size() << " -> " << merged.size() << " bytes" << std::endl;
+		m_PatchedData.swap(merged);
+	}
+	return retVal;
+}
+
+bool CElfReader::CorrectApplicationHeaderStructure(bool appendinfoblock, uint32_t appinfoaddress, uint32_t DXEPointer)
+{
+	bool retVal = true;
+	//what's missing is patching the first argument -> it's pointing to the next dxe.
+	//Therefore we have to iterate to the final block and adjust the first argument.
+	if (DXEPointer + sizeof(TFlashHeader) < m_PatchedData.size())
+	{
+		//iterate to the final block of the dxe
+		CLdrStreamCursor<const TFlashHeader, BFLAG_FILL> cursor(m_PatchedData, DXEPointer);
+		while ((cursor.GetHeader() != nullptr) && !(cursor.GetHeader()->usFlags & BFLAG_FINAL))
+		{
+			cursor.Next();
+		}
+
+		if (cursor.GetHeader() != nullptr)
+		{
+			//the restructured stream is planned again and rebuilt once
+			CPatchJournal journal(m_PatchedData, 0);
+			if (appendinfoblock)
+			{
+				//the final block is moved behind an IGNORE block carrying the info block
+				retVal = PlanInfoBlock(journal, cursor.GetOffset(), appinfoaddress) && journal.SetEnd(cursor.GetNextOffset());
+			}
+
+			//recreate the initial header
+			retVal = retVal && PlanDxeArgument(journal, DXEPointer, journal.GetOutputOffset(cursor.GetNextOffset()) - DXEPointer);
+			if (retVal)
+			{
+				std::vector<uint8_t> corrected;
+				corrected.reserve(journal.GetOutputSize());
+				CVectorSink sink(corrected);
+				retVal = journal.Apply(sink);
+				m_PatchedData.swap(corrected);
+			}
+		}
+		else
+		{
+			std::cerr << "Invalid data stream. Final block missing." << std::endl;
+			retVal = false;
+		}
+	}
+	else
+	{
+		retVal = false;
+	}
+	return retVal;
+}
+
+bool CElfReader::PlanInfoBlock(CPatchJournal& journal, size_t offset, uint32_t appinfoaddress)
+{
+	//IGNORE block carrying the info block, inserted in front of the final block
+	TFlashHeader header;
+	bool retVal = CreateHeader(&header, BFLAG_IGNORE, appinfoaddress, sizeof(ST_APPINFOS), 0);
+	if (retVal)
+	{
+		//getting pointer to dxdata
+		const uint8_t* t = GetMemoryContent(appinfoaddress, appinfoaddress + sizeof(ST_APPINFOS));
+		if (t != nullptr)
+		{
+			const ST_APPINFOS* info = reinterpret_cast<const ST_APPINFOS*>(t);
+			std::cout << "Device Name: " << info->ac8_DeviceName << std::endl
+				<< "Build No: " << std::dec << info->u16_FW_BuildNumber << std::endl
+				<< "Module Id: " << info->u16_ModuleID << std::endl
+				<< "Version Info: " << info->u32_FW_VersionNumber << std::endl;
+
+			retVal = journal.BeginEdit(CPatchJournal::INSERT_INFO_BLOCK, offset, 0);
+			journal.AppendLiteral(&header, sizeof(TFlashHeader));
+			journal.AppendView(t, sizeof(ST_APPINFOS));
+		}
+		else
+		{
+			std::cerr << "Error while creating IGNORE block. Invalid memory section." << std::endl;
+			retVal = false;
+		}
+	}
+	else
+	{
+		std::cerr << "Error while creating IGNORE block." << std::endl;
+	}
+	return retVal;
+}
+
+bool CElfReader::PlanDxeArgument(CPatchJournal& journal, size_t offset, size_t length)
+{
+	//the argument of the initial header is the length of the DXE behind it
+	TFlashHeader header;
+	bool retVal = (length >= sizeof(TFlashHeader)) && journal.Read(offset, &header, sizeof(TFlashHeader));
+	if (retVal)
+	{
+		CreateHeader(&header, header.usFlags, header.ulRamAddr, header.ulBlockLen, static_cast<uint32_t>(length - sizeof(TFlashHeader)));
+		retVal = journal.Overlay(CPatchJournal::FIX_DXE_ARGUMENT, offset, &header, sizeof(TFlashHeader));
+	}
+	return retVal;
+}
+
+bool CElfReader::WritePatchedStream(const std::string& filename) const
+{
+	CFileSink sink(filename);
+	bool retVal = sink.IsOpen();
+	if (m_pJournal != nullptr)
+	{
+		//patched once, the journal is applied to the file directly
+		retVal = retVal && m_pJournal->Apply(sink);
+	}
+	else
+	{
+		retVal = retVal && sink.Write(m_PatchedData.data(), m_PatchedData.size());
+	}
+	retVal = sink.Close() && retVal;
+	if (retVal)
+	{
+		std::cout << std::dec << "Patched stream written to " << filename << " (" << m_PatchedData.size() << " bytes" << ((m_pJournal != nullptr) ? ", applied from the patch journal" : "") << ")" << std::endl;
+	}
+	else
+	{
+		std::cerr << "Unable to write " << filename << std::endl;
+	}
+	return retVal;
+}
+
+void CElfReader::SetPatchCache(CPatchCache *cache)
+{
+	m_pCache = cache;
+}
+
+void CElfReader::SetCrcMemo(CCrcMemo *memo)
+{
+	m_pCrcMemo = memo;
+}
+
+void CElfReader::WriteDescriptorTable()
+{
+	//the memory image keeps a copy for the integrity check
+	const std::vector<uint8_t>& data = m_DescriptorTable.GetData();
+	const size_t offset = m_DescriptorTable.GetAddress() - m_MemoryLayout[0].OffsetCompensation;
+	if (offset < m_SDRAM.size())
+	{
+		memcpy(&m_SDRAM[offset], data.data(), std::min(data.size(), m_SDRAM.size() - offset));
+	}
+}
+
+void CElfReader::AppendMemoryContent(CPatchJournal& journal, const uint8_t* content, uint32_t address, uint32_t length) const
+{
+	//the descriptor table comes from the table builder, not from the memory image
+	const std::vector<uint8_t>& table = m_DescriptorTable.GetData();
+	const uint64_t stop = static_cast<uint64_t>(address) + length;
+	const uint64_t tablestart = std::max<uint64_t>(address, m_DescriptorTable.GetAddress());
+	const uint64_t tablestop = std::min<uint64_t>(stop, static_cast<uint64_t>(m_DescriptorTable.GetAddress()) + table.size());
+	if (tablestart < tablestop)
+	{
+		journal.AppendView(content, static_cast<size_t>(tablestart - address));
+		journal.AppendLiteral(&table[static_cast<size_t>(tablestart - m_DescriptorTable.GetAddress())], static_cast<size_t>(tablestop - tablestart));
+		journal.AppendView(content + (tablestop - address), static_cast<size_t>(stop - tablestop));
+	}
+	else
+	{
+		journal.AppendView(content, length);
+	}
+}
+
+std::vector<CElfReader::MemoryTable> CElfReader::PartitionEntries(const std::vector<MemoryTable>& table, uint32_t budget) const
+{
+	//lengths in 16 bit words - the parts of an entry keep the alignment of its start address
+	const ptrdiff_t words = std::max<ptrdiff_t>(static_cast<ptrdiff_t>(budget / sizeof(uint16_t)), 1);
+
+	//contiguous entries of the same memory section are merged up to the budget
+	std::vector<MemoryTable> merged;
+	for (auto& value : table)
+	{
+		if (!merged.empty() && (merged.back().stopaddress == value.startaddress) && (merged.back().m_bDMAAccess == value.m_bDMAAccess)
+			&& (value.stopaddress - merged.back().startaddress <= words)
+			&& (GetMemoryContent(reinterpret_cast<uint32_t>(merged.back().startaddress), reinterpret_cast<uint32_t>(value.stopaddress)) != nullptr))
+		{
+			merged.back().stopaddress = value.stopaddress;
+		}
+		else
+		{
+			merged.push_back(value);
+		}
+	}
+
+	//larger entries are split into parts of equal length
+	std::vector<MemoryTable> partitioned;
+	for (auto& value : merged)
+	{
+		const ptrdiff_t length = value.stopaddress - value.startaddress;
+		if (length > words)
+		{
+			const ptrdiff_t parts = (length + words - 1) / words;
+			const ptrdiff_t partlength = (length + parts - 1) / parts;
+			MemoryTable part = value;
+			for (ptrdiff_t offset = 0; offset < length; offset += partlength)
+			{
+				part.startaddress = value.startaddress + offset;
+				part.stopaddress = value.startaddress + std::min(offset + partlength, length);
+				partitioned.push_back(part);
+			}
+		}
+		else
+		{
+			partitioned.push_back(value);
+		}
+	}
+	return partitioned;
+}
+
+void CElfReader::PartitionMemTable()
+{
+	const size_t capacity = sizeof(m_MemoryTable) / sizeof(m_MemoryTable[0]);
+	uint32_t budget = m_u32CrcBudget;
+	std::vector<MemoryTable> partitioned = PartitionEntries(RegeneratedMemTable, budget);
+	if (partitioned.size() > capacity)
+	{
+		//smallest budget that fits into the table
+		uint32_t lower = budget;
+		uint32_t upper = 0xFFFFFFFFu;
+		partitioned = PartitionEntries(RegeneratedMemTable, upper);
+		if (partitioned.size() <= capacity)
+		{
+			while (upper - lower > sizeof(uint16_t))
+			{
+				const uint32_t middle = lower + (upper - lower) / 2;
+				std::vector<MemoryTable> candidate = PartitionEntries(RegeneratedMemTable, middle);
+				if (candidate.size() <= capacity)
+				{
+					upper = middle;
+					partitioned.swap(candidate);
+				}
+				else
+				{
+					lower = middle;
+				}
+			}
+			std::cout << std::hex << "CRC budget raised to 0x" << upper << " bytes to fit into " << std::dec << capacity << " table entries." << std::endl;
+			budget = upper;
+		}
+		else
+		{
+			std::cerr << std::dec << "CRC budget can't be met. " << partitioned.size() << " table entries even without splitting." << std::endl;
+		}
+	}
+
+	uint32_t worstcase = 0;
+	for (auto& value : partitioned)
+	{
+		worstcase = std::max<uint32_t>(worstcase, static_cast<uint32_t>((value.stopaddress - value.startaddress) * sizeof(*value.startaddress)));
+	}
+	std::cout << std::dec << "CRC partitioning: " << RegeneratedMemTable.size() << " -> " << partitioned.size() << " entries, worst case per time slice 0x"
+		<< std::hex << worstcase << " bytes (budget 0x" << budget << ")" << std::endl;
+	RegeneratedMemTable.swap(partitioned);
+}
+
+void CElfReader::PackMemTable(const std::vector<CIntervalEngine::TInterval>& layout)
+{
+	typedef CIntervalEngine::TInterval TInterval;
+	struct TRun
+	{
+		TInterval	Range;
+		bool		DMAAccess;
+		bool		Required;	/**< contains a table entry, pure fill runs only use spare entries */
+	};
+	const size_t capacity = sizeof(m_MemoryTable) / sizeof(m_MemoryTable[0]);
+	const size_t budget = std::min<size_t>(m_u32CrcPackEntries, capacity);
+	auto bytes = [](const TInterval& range) { return static_cast<uint64_t>(range.Stop - range.Start); };
+	const CRangeIndex layoutindex(layout);
+
+	//constant at runtime: last written by a fill block, inside a layout range, outside of the SDRAM window written by the target (descriptor table, CRC state), 16 bit aligned
+	std::vector<TInterval> constant;
+	const std::vector<TInterval> filled = CIntervalEngine::FindLastWritten(m_LoadedBlocks, m_LoadedFill);
+	for (auto& range : layout)
+	{
+		for (auto& fill : filled)
+		{
+			const TInterval parts[] = { { std::max(fill.Start, range.Start), std::min({ fill.Stop, range.Stop, IgnoreSDRAMLower }) },
+				{ std::max({ fill.Start, range.Start, IgnoreSDRAMUpper + 1 }), std::min(fill.Stop, range.Stop) } };
+			for (auto& part : parts)
+			{
+				const TInterval aligned = { (part.Start + 1) & ~1u, part.Stop & ~1u };
+				if (aligned.Start < aligned.Stop)
+				{
+					constant.push_back(aligned);
+				}
+			}
+		}
+	}
+
+	//table entries and the constant bytes they don't cover, by address
+	std::vector<TRun> segments;
+	std::vector<TInterval> entries;
+	uint64_t checkedbefore = 0;
+	for (auto& value : RegeneratedMemTable)
+	{
+		TRun segment = { { reinterpret_cast<uint32_t>(value.startaddress), reinterpret_cast<uint32_t>(value.stopaddress) }, value.m_bDMAAccess, true };
+		segments.push_back(segment);
+		entries.push_back(segment.Range);
+		checkedbefore += bytes(segment.Range);
+	}
+	const std::vector<TInterval> covered = CIntervalEngine::FindLastWritten(entries, std::vector<bool>(entries.size(), true));
+	std::sort(constant.begin(), constant.end(), [](const TInterval& a, const TInterval& b) { return a.Start < b.Start; });
+	size_t c = 0;
+	for (auto& range : constant)
+	{
+		uint32_t start = range.Start;
+		while (c < covered.size() && covered[c].Stop <= start)
+		{
+			++c;
+		}
+		for (size_t i = c; i < covered.size() && covered[i].Start < range.Stop && start < range.Stop; ++i)
+		{
+			if (start < covered[i].Start)
+			{
+				segments.push_back({ { start, covered[i].Start }, RequiresDMAAccess(start, covered[i].Start), false });
+			}
+			start = std::max(start, covered[i].Stop);
+		}
+		if (start < range.Stop)
+		{
+			segments.push_back({ { start, range.Stop }, RequiresDMAAccess(start, range.Stop), false });
+		}
+	}
+	std::stable_sort(segments.begin(), segments.end(), [](const TRun& a, const TRun& b) { return a.Range.Start < b.Range.Start; });
+
+	//touching segments are merged as long as they stay in one layout range and memory section with the same access
+	auto checkable = [&](const TInterval& range, bool dma)
+	{
+		return (GetMemoryContent(range.Start, range.Stop) != nullptr) && !IgnoreMemorySection(range.Start, range.Stop) && (RequiresDMAAccess(range.Start, range.Stop) == dma);
+	};
+	std::vector<TRun> runs;
+	for (auto& segment : segments)
+	{
+		const TInterval merged = runs.empty() ? segment.Range : TInterval{ runs.back().Range.Start, segment.Range.Stop };
+		if (!runs.empty() && (runs.back().Range.Stop == segment.Range.Start) && (runs.back().DMAAccess == segment.DMAAccess)
+			&& layoutindex.Contains(merged) && checkable(merged, segment.DMAAccess))
+		{
+			runs.back().Range.Stop = segment.Range.Stop;
+			runs.back().Required = runs.back().Required || segment.Required;
+		}
+		else if (segment.Required || checkable(segment.Range, segment.DMAAccess))
+		{
+			runs.push_back(segment);
+		}
+	}
+
+	//the entries with table entries first, then the largest runs
+	std::vector<size_t> order(runs.size());
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+	{
+		return (runs[a].Required != runs[b].Required) ? runs[a].Required : bytes(runs[a].Range) > bytes(runs[b].Range);
+	});
+	std::vector<bool> selected(runs.size(), false);
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		selected[order[i]] = i < budget;
+		if (i >= budget && runs[order[i]].Required)
+		{
+			std::cerr << std::hex << "CRC packing: block 0x" << runs[order[i]].Range.Start << " 0x" << runs[order[i]].Range.Stop << " dropped (table entry budget)" << std::endl;
+		}
+	}
+
+	std::vector<MemoryTable> packed;
+	uint64_t checkedafter = 0;
+	for (size_t i = 0; i < runs.size(); ++i)
+	{
+		if (selected[i])
+		{
+			MemoryTable entry;
+			memset(&entry, 0, sizeof(MemoryTable));
+			entry.startaddress = reinterpret_cast<uint16_t*>(runs[i].Range.Start);
+			entry.stopaddress = reinterpret_cast<uint16_t*>(runs[i].Range.Stop);
+			entry.m_bDMAAccess = runs[i].DMAAccess;
+			packed.push_back(entry);
+			checkedafter += bytes(runs[i].Range);
+		}
+	}
+
+	const double stream = static_cast<double>(std::max<size_t>(m_StreamLength, 1));
+	std::cout << std::dec << "CRC packing: " << RegeneratedMemTable.size() << " -> " << packed.size() << " entries (budget " << budget << "), checked bytes 0x" << std::hex << checkedbefore
+		<< " (" << std::dec << 100.0 * checkedbefore / stream << " %) -> 0x" << std::hex << checkedafter << " (" << std::dec << 100.0 * checkedafter / stream << " %) of the stream" << std::endl;
+	RegeneratedMemTable.swap(packed);
+}
+
+void CElfReader::ReportCoverage(const std::vector<CIntervalEngine::TInterval>& overlapped) const
+{
+	static const size_t MaxReportedGaps = 16;
+	for (auto& region : m_MemoryLayout)
+	{
+		const uint32_t start = static_cast<uint32_t>(region.StartAddress);
+		const uint32_t stop = static_cast<uint32_t>(region.StartAddress + region.Length);
+		//regions without loaded blocks aren't mapped
+		bool loaded = false;
+		for (auto& block : m_LoadedBlocks)
+		{
+			loaded = loaded || (block.Start < stop && start < block.Stop);
+		}
+		if (!loaded)
+		{
+			continue;
+		}
+
+		//CRC table entries are halfword aligned, coarser granules would report the boundaries as unprotected
+		CCoverageMap map(start, static_cast<uint32_t>(region.Length), sizeof(uint16_t));
+		for (auto& block : m_LoadedBlocks)
+		{
+			map.Mark(CCoverageMap::LOADED, block.Start, block.Stop);
+		}
+		for (auto& value : RegeneratedMemTable)
+		{
+			map.Mark(CCoverageMap::PROTECTED, reinterpret_cast<uint32_t>(value.startaddress), reinterpret_cast<uint32_t>(value.stopaddress));
+		}
+		for (auto& block : overlapped)
+		{
+			map.Mark(CCoverageMap::OVERLAPPED, block.Start, block.Stop);
+		}
+		if (region.Ignore)
+		{
+			map.MarkAll(CCoverageMap::IGNORED);
+		}
+		map.Mark(CCoverageMap::IGNORED, IgnoreSDRAMLower, IgnoreSDRAMUpper + 1);
+
+		const uint64_t loadedbytes = map.Count(CCoverageMap::LOADED);
+		const uint64_t protectedbytes = map.CountLoaded(CCoverageMap::PROTECTED);
+		std::cout << std::hex << "Coverage of region 0x" << start << " - 0x" << stop << ": loaded 0x" << loadedbytes << ", CRC protected 0x" << protectedbytes
+			<< " (" << std::dec << 100.0 * protectedbytes / std::max<uint64_t>(loadedbytes, 1) << " %), ignored 0x" << std::hex << map.CountLoaded(CCoverageMap::IGNORED)
+			<< ", dropped overlaps 0x" << map.Count(CCoverageMap::OVERLAPPED) << ", unprotected 0x" << map.CountUnprotected() << " bytes" << std::endl;
+
+		const std::vector<CCoverageMap::TGap> gaps = map.FindGaps();
+		for (size_t i = 0; i < std::min(gaps.size(), MaxReportedGaps); ++i)
+		{
+			std::cout << std::hex << "\tUnprotected gap 0x" << gaps[i].Start << " - 0x" << gaps[i].Stop << " (0x" << gaps[i].Stop - gaps[i].Start << " bytes)" << std::endl;
+		}
+		if (gaps.size() > MaxReportedGaps)
+		{
+			std::cout << std::dec << "\t" << gaps.size() - MaxReportedGaps << " smaller gaps not listed" << std::endl;
+		}
+	}
+}
+
+void CElfReader::CalcMemTableCrc()
+{
+	//CRCs of all entries that are covered by the memory image, up to the first one that isn't (reported by the caller)
+	std::vector<CParallelCrc::TBlock> blocks;
+	blocks.reserve(RegeneratedMemTable.size());
+	for (auto& value : RegeneratedMemTable)
+	{
+		const uint8_t *d = GetMemoryContent(reinterpret_cast<uint32_t>(value.startaddress), reinterpret_cast<uint32_t>(value.stopaddress));
+		if (d == nullptr)
+		{
+			break;
+		}
+		CParallelCrc::TBlock block = { d, static_cast<uint32_t>((value.stopaddress - value.startaddress) * sizeof(*value.startaddress)), 0 };
+		blocks.push_back(block);
+	}
+
+	if (m_pCache != nullptr || m_pCrcMemo != nullptr)
+	{
+		//hashes in parallel, the cache and the memo are only accessed from this thread
+		std::vector<CContentHash::THash128> keys(blocks.size());
+		CParallelCrc::Run(blocks.size(), [&](size_t i) { keys[i] = CContentHash::Calc(blocks[i].Data, blocks[i].Length, CRCSeed); });
+
+		std::vector<CParallelCrc::TBlock> missing;
+		std::vector<size_t> missingindex;
+		for (size_t i = 0; i < blocks.size(); ++i)
+		{
+			const bool found = (m_pCrcMemo != nullptr && m_pCrcMemo->Find(keys[i], blocks[i].Length, blocks[i].Crc))
+				|| (m_pCache != nullptr && m_pCache->FindCrc(keys[i], blocks[i].Crc));
+			if (!found)
+			{
+				missing.push_back(blocks[i]);
+				missingindex.push_back(i);
+			}
+		}
+		CParallelCrc::CalcBlocks(CRCSeed, missing);
+		for (size_t i = 0; i < missing.size(); ++i)
+		{
+			blocks[missingindex[i]].Crc = missing[i].Crc;
+			if (m_pCrcMemo != nullptr)
+			{
+				m_pCrcMemo->Store(keys[missingindex[i]], missing[i].Crc);
+			}
+			if (m_pCache != nullptr)
+			{
+				m_pCache->StoreCrc(keys[missingindex[i]], missing[i].Crc);
+			}
+		}
+	}
+	else
+	{
+		CParallelCrc::CalcBlocks(CRCSeed, blocks);
+	}
+
+	for (size_t i = 0; i < blocks.size(); ++i)
+	{
+		RegeneratedMemTable[i].m_u16CRC = blocks[i].Crc;
+	}
+}
+
+bool CElfReader::PatchMemory(const std::vector<TMemoryPatch>& patches)
+{
+	//the memory image is only modified if the CRCs of all patches could be updated
+	bool retVal = true;
+	std::vector<uint8_t*> targets;
+	for (auto& patch : patches)
+	{
+		const uint32_t stop = patch.Address + static_cast<uint32_t>(patch.Data.size());
+		uint8_t *p = const_cast<uint8_t*>(GetMemoryContent(patch.Address, stop));
+		if (p == nullptr)
+		{
+			std::cerr << std::hex << "Unable to patch memory at 0x" << patch.Address << ". Invalid memory section." << std::endl;
+			retVal = false;
+			break;
+		}
+		else if (patch.Address < FlashLayoutCRCTable + sizeof(m_MemoryTable) && stop > FlashLayoutCRCTable)
+		{
+			std::cerr << std::hex << "Unable to patch memory at 0x" << patch.Address << ". The CRC table can't be patched." << std::endl;
+			retVal = false;
+			break;
+		}
+		targets.push_back(p);
+	}
+
+	std::vector<uint16_t> crc(RegeneratedMemTable.size());
+	for (size_t i = 0; retVal && i < RegeneratedMemTable.size(); ++i)
+	{
+		const uint32_t start = reinterpret_cast<uint32_t>(RegeneratedMemTable[i].startaddress);
+		const uint32_t stop = reinterpret_cast<uint32_t>(RegeneratedMemTable[i].stopaddress);
+		std::vector<CCrcUpdate::TModification> modifications;
+		for (size_t j = 0; j < patches.size(); ++j)
+		{
+			const uint32_t first = std::max(start, patches[j].Address);
+			const uint32_t last = std::min(stop, patches[j].Address + static_cast<uint32_t>(patches[j].Data.size()));
+			if (first < last)
+			{
+				CCrcUpdate::TModification modification = { first - start, last - first, targets[j] + (first - patches[j].Address), &patches[j].Data[first - patches[j].Address] };
+				modifications.push_back(modification);
+			}
+		}
+		crc[i] = RegeneratedMemTable[i].m_u16CRC;
+		if (!modifications.empty() && !CCrcUpdate::Update(crc[i], stop - start, modifications))
+		{
+			std::cerr << std::hex << "Unable to patch memory. Overlapping patches in block 0x" << start << "-0x" << stop << std::endl;
+			retVal = false;
+		}
+	}
+
+	if (retVal)
+	{
+		for (size_t j = 0; j < patches.size(); ++j)
+		{
+			std::copy(patches[j].Data.begin(), patches[j].Data.end(), targets[j]);
+		}
+		for (size_t i = 0; i < RegeneratedMemTable.size(); ++i)
+		{
+			RegeneratedMemTable[i].m_u16CRC = crc[i];
+			(void)m_DescriptorTable.SetCrc(i, crc[i]);
+		}
+		if (!m_DescriptorTable.IsEmpty())
+		{
+			WriteDescriptorTable();
+		}
+	}
+	return retVal;
+}
+
+bool CElfReader::StampAppInfo(uint32_t appinfoaddress, uint32_t version, uint32_t build)
 {
-	bool retVal = true;
-	//what's missing is patching the first argument -> it's pointing to the next dxe.
-	//Therefore we have to iterate to the final block and adjust the first argument.
-	//iterate to the final dxe$
+	bool retVal = (build <= 0xFFFFu);
+	if (retVal)
+	{
+		const ST_APPINFOS* info = reinterpret_cast<const ST_APPINFOS*>(GetMemoryContent(appinfoaddress, appinfoaddress + sizeof(ST_APPINFOS)));
+		if (info != nullptr)
+		{
+			std::cout << "Stamping " << info->ac8_DeviceName << ": version " << std::dec << info->u32_FW_VersionNumber << " -> " << version
+				<< ", build " << info->u16_FW_BuildNumber << " -> " << build << std::endl;
+		}
+		//the fields are little endian on the target as well as on the host
+		const uint16_t buildnumber = static_cast<uint16_t>(build);
+		const uint8_t* v = reinterpret_cast<const uint8_t*>(&version);
+		const uint8_t* b = reinterpret_cast<const uint8_t*>(&buildnumber);
+		const std::vector<TMemoryPatch> patches =
+		{
+			{ appinfoaddress + static_cast<uint32_t>(offsetof(ST_APPINFOS, u32_FW_VersionNumber)), std::vector<uint8_t>(v, v + sizeof(version)) },
+			{ appinfoaddress + static_cast<uint32_t>(offsetof(ST_APPINFOS, u16_FW_BuildNumber)), std::vector<uint8_t>(b, b + sizeof(buildnumber)) },
+		};
+		retVal = PatchMemory(patches);
+	}
+	else
+	{
+		std::cerr << std::dec << "Unable to stamp the application info. Build number " << build << " exceeds 16 bit." << std::endl;
+	}
+	return retVal;
+}
 
-	TFlashHeader* const pInitialHdr = reinterpret_cast<TFlashHeader*>(&m_PatchedData[DXEPointer]);
-	if (DXEPointer + sizeof(TFlashHeader) < m_PatchedData.size())
+bool CElfReader::GetBlockKey(const TFlashHeader *header, CPatchCache::THash128 &key) const
+{
+	//header is a validated view -> the payload follows the header
+	bool retVal = false;
+	const uint32_t payload = (header->usFlags & BFLAG_FILL) ? 0 : header->ulBlockLen;
+	key = CContentHash::Calc(header, sizeof(TFlashHeader) + payload);
+	if (header->usFlags & BFLAG_IGNORE)
+	{
+		//copied as it is
+		retVal = true;
+	}
+	else
 	{
-		//in this case we have to do some additional work
-		if (appendinfoblock)
+		//the patched block depends on the memory image the block is loaded to
+		const uint8_t *content = GetMemoryContent(header->ulRamAddr, header->ulRamAddr + header->ulBlockLen);
+		if (content != nullptr)
 		{
-			uint32_t argument = 0;
-			TFlashHeader* pHdr = pInitialHdr;
-			while (DXEPointer + sizeof(TFlashHeader) < m_PatchedData.size() && !(pHdr->usFlags & BFLAG_FINAL))
-			{
-				DXEPointer += sizeof(TFlashHeader);
-				DXEPointer += (pHdr->usFlags & BFLAG_FILL) ? 0 : pHdr->ulBlockLen;
-				argument += sizeof(TFlashHeader);
-				argument += (pHdr->usFlags & BFLAG_FILL) ? 0 : pHdr->ulBlockLen;
-				pHdr = reinterpret_cast<TFlashHeader*>(&m_PatchedData[DXEPointer]);
-			}
-			if (pHdr->usFlags & BFLAG_FINAL)
-			{
-				std::vector<uint8> finalblock;
-				//TFlashHeader finalheader;
-				//memcpy(&finalheader, pHdr, sizeof(TFlashHeader));
-				uint32_t blocksize = pHdr->ulBlockLen + sizeof(TFlashHeader);
-				finalblock.reserve(blocksize);
-				for (uint32_t i = 0; i < blocksize; ++i)
-				{
-					finalblock.push_back(m_PatchedData[i + DXEPointer]);
-					//m_PatchedData[i + DXEPointer] = 0;
-				}
+			key = CContentHash::Combine(key, content, header->ulBlockLen);
+			retVal = true;
+		}
+	}
+	return retVal;
+}
 
-				m_PatchedData.resize(DXEPointer + sizeof(TFlashHeader));
-				//now m_PatchedData's last header is erased
-				//create a new header - pHdr is still valid -> in place generation. Header does exist
-				if (CreateHeader(pHdr, BFLAG_IGNORE, appinfoaddress, sizeof(ST_APPINFOS), 0))
-				{
-					//getting pointer to dxdata
-					const uint8_t* t = GetMemoryContent(appinfoaddress, appinfoaddress + sizeof(ST_APPINFOS));
-					if (t!=nullptr)
-					{
-						const ST_APPINFOS* info = reinterpret_cast<const ST_APPINFOS*>(t);
-						std::cout << "Device Name: " << info->ac8_DeviceName << std::endl
-							<< "Build No: " << std::dec << info->u16_FW_BuildNumber << std::endl
-							<< "Module Id: " << info->u16_ModuleID << std::endl
-							<< "Version Info: " << info->u32_FW_VersionNumber << std::endl;
-
-						/*uint32_t i;
-						for (i = 0; i < sizeof(ST_APPINFOS)&& i + sizeof(TFlashHeader) + DXEPointer < m_PatchedData.size(); ++i)
-						{
-							m_PatchedData[i + sizeof(TFlashHeader) + DXEPointer] = t[i];
-						}*/
-						for (uint32_t i = 0; i < sizeof(ST_APPINFOS); ++i)
-						{
-							m_PatchedData.push_back(t[i]);
-						}
-						argument += sizeof(ST_APPINFOS) + sizeof(TFlashHeader);
-						//adding final header.
-						//not very efficient -> but it is just one final header
-						uint32_t i = 0;
-						for (std::vector<uint8>::iterator iter = finalblock.begin(); iter != finalblock.end(); ++iter)
-						{
-							//if (m_PatchedData.size() <= i + sizeof(TFlashHeader) + DXEPointer + sizeof(ST_APPINFOS))
-							//{
-							m_PatchedData.push_back(*iter);
-							//}
-							/*else
-							{
-								m_PatchedData[i + sizeof(TFlashHeader) + DXEPointer + sizeof(ST_APPINFOS)] = *iter;
-							}*/
-							++i;
-						}
-						argument += blocksize;
-					}
-					else
-					{
-						std::cerr << "Error while creating IGNORE block. Invalid memory section." << std::endl;
-						retVal = false;
-					}
-				}
-				else
-				{
-					std::cerr << "Error while creating IGNORE block." << std::endl;
-					retVal = false;
-				}
+uint32_t CElfReader::FindApplicationStart() const
+{
+	//iterate to the final dxe - the argument of the initial header skips the dxe
+	uint32_t RawPointer = 0;
+	size_t DXEPointer = 0;
+	bool found = true;
+	while (found)
+	{
+		CLdrStreamCursor<const TFlashHeader, BFLAG_FILL> cursor(m_FileRawData, DXEPointer);
+		const TFlashHeader *pHdr = cursor.GetHeader();
+		found = (pHdr != nullptr) && CheckHeader(pHdr) && ((pHdr->usFlags&(BFLAG_IGNORE | BFLAG_FIRST)) == (BFLAG_IGNORE | BFLAG_FIRST));
+		if (found)
+		{
+			RawPointer = static_cast<uint32_t>(DXEPointer);
+			//64 bit - a corrupt argument can't wrap the pointer back, every step moves forward by a header at least
+			const uint64_t next = static_cast<uint64_t>(DXEPointer) + sizeof(TFlashHeader) + pHdr->Argument;
+			found = next < m_FileRawData.size();
+			DXEPointer = static_cast<size_t>(next);
+		}
+	}
+	return RawPointer;
+}
 
-				//pointing to the last block -> save it and append it
-				pHdr = pInitialHdr;
-				pHdr->Argument = argument - sizeof(TFlashHeader);//the size of initial block has to be subtracted
-				//argument += sizeof(TFlashHeader);
-				//argument += pHdr->usFlags&BFLAG_FILL ? 0 : pHdr->ulBlockLen;
-				//pHdr->Argument = argument;
-				//pHdr->usFlags &= 0x0000FFFF;
-				//recreate header
-				CreateHeader(pHdr, pHdr->usFlags, pHdr->ulRamAddr, pHdr->ulBlockLen, pHdr->Argument);
-			}
-			else
-			{
-				std::cerr << "Invalid data stream. Final block missing." << std::endl;
-				retVal = false;
-			}
+bool CElfReader::AccumulateBootTime(const std::vector<uint8_t> &stream, size_t RawPointer, const CBootTimeEstimator &estimator, CBootTimeEstimator::TBootTime &time) const
+{
+	bool retVal = true;
+	CLdrStreamCursor<const TFlashHeader, BFLAG_FILL> cursor(stream, RawPointer);
+	const TFlashHeader *pHdr;
+	do {
+		pHdr = cursor.GetHeader();
+		if (pHdr == nullptr)
+		{
+			retVal = false;
+			break;
+		}
+		estimator.AddBlock(time, (pHdr->usFlags & BFLAG_FILL) != 0, (pHdr->usFlags & BFLAG_IGNORE) != 0, (pHdr->usFlags & BFLAG_INIT) != 0, (pHdr->usFlags & BFLAG_CALLBACK) != 0,
+			pHdr->ulBlockLen, RequiresDMAAccess(pHdr->ulRamAddr, pHdr->ulRamAddr + pHdr->ulBlockLen));
+		cursor.Next();
+	} while (!(pHdr->usFlags & BFLAG_FINAL));
+	return retVal;
+}
+
+void CElfReader::PrintStreamChecksums() const
+{
+	//all checksums in one pass over the stream
+	CCrcSet<CCrc16Ccitt, CCrc16Modbus, CCrc32> crc;
+	crc.Update(m_PatchedData.data(), m_PatchedData.size());
+	std::cout << std::hex << "Stream checksums: CRC-16/CCITT 0x" << crc.Get<0>() << " CRC-16/MODBUS 0x" << crc.Get<1>() << " CRC-32 0x" << crc.Get<2>()
+		<< std::dec << " (" << m_PatchedData.size() << " bytes)" << std::endl;
+}
+
+bool CElfReader::EstimateBootTime(CBootTimeEstimator::TCostModel model, uint32_t bootflags) const
+{
+	bool retVal;
+	model.FastRead = (bootflags & BFLAG_FASTREAD) != 0;
+	model.AddressBytes = ((bootflags & BFLAG_TYPE4) >> 20) + 1;
+	const CBootTimeEstimator estimator(model);
+	CBootTimeEstimator::TBootTime original = CBootTimeEstimator::Empty();
+	CBootTimeEstimator::TBootTime patched = CBootTimeEstimator::Empty();
+
+	if (m_PatchedData.size())
+	{
+		retVal = AccumulateBootTime(m_FileRawData, FindApplicationStart(), estimator, original);
+		retVal = retVal && AccumulateBootTime(m_PatchedData, 0, estimator, patched);
+		if (retVal)
+		{
+			estimator.PrintComparison(original, patched);
 		}
 		else
 		{
-			uint32_t argument = 0;
-			TFlashHeader* pHdr = pInitialHdr;
-			while (DXEPointer + sizeof(TFlashHeader) < m_PatchedData.size() && !(pHdr->usFlags & BFLAG_FINAL))
-			{
-				DXEPointer += sizeof(TFlashHeader);
-				DXEPointer += (pHdr->usFlags & BFLAG_FILL) ? 0 : pHdr->ulBlockLen;
-				argument += sizeof(TFlashHeader);
-				argument += (pHdr->usFlags & BFLAG_FILL) ? 0 : pHdr->ulBlockLen;
-				pHdr = reinterpret_cast<TFlashHeader*>(&m_PatchedData[DXEPointer]);
-			}
-			if (pHdr->usFlags & BFLAG_FINAL)
-			{
-				argument += pHdr->ulBlockLen + sizeof(TFlashHeader);
-				TFlashHeader* pHdr = pInitialHdr;
-				pHdr->Argument = argument - sizeof(TFlashHeader);//subtract size of first header
-				pHdr->usFlags &= 0x0000FFFF;
-				CreateHeader(pHdr, pHdr->usFlags, pHdr->ulRamAddr, pHdr->ulBlockLen, pHdr->Argument);
-			}
-			else
-			{
-				std::cerr << "Invalid data stream. Final block missing." << std::endl;
-				retVal = false;
-			}
+			std::cerr << "Unable to estimate boot time. Invalid data stream." << std::endl;
 		}
 	}
 	else
 	{
+		std::cerr << "Unable to estimate boot time. File not patched." << std::endl;
 		retVal = false;
 	}
 	return retVal;
@@ -792,34 +1612,53 @@ bool CElfReader::CorrectApplicationHeaderStructure(bool appendinfoblock, uint32_
 bool CElfReader::PatchFile(bool appendinfoblock, uint32_t appinfoaddress)
 {
 	bool retVal;
-	m_PatchedData.reserve(2 * m_FileRawData.size());
-	uint32_t PrevHeaderId=-1;
+	//the edits are planned first, the output is assembled once its size is known
+	struct TCachedSegment
+	{
+		CPatchCache::THash128	Key;
+		size_t					Start;
+		size_t					Length;
+	};
+	const uint32_t ApplicationStart = FindApplicationStart();
+	//the optimizers restructure the assembled stream, the header fixes are planned afterwards
+	const bool restructure = m_bOptimizeFill || m_bMergeBlocks;
+	CPatchJournal journal(m_FileRawData, ApplicationStart);
+	m_pJournal.reset();
+	std::vector<TCachedSegment> segments;
 	if (eElfStatus == ELF_OK)
 	{
-		TFlashHeader *pHdr;
+		const TFlashHeader *pHdr;
 		uint32_t RawPointer = 0;
 		uint32_t DXEPointer = 0;
 		uint32_t PatchOffset = 0;
 		retVal = true;
 
-		//iterate to the final dxe
-		while (DXEPointer < m_FileRawData.size())
-		{
-			pHdr = reinterpret_cast<TFlashHeader*>(&m_FileRawData[DXEPointer]);
-			if ((pHdr->usFlags&(BFLAG_IGNORE | BFLAG_FIRST))==(BFLAG_IGNORE | BFLAG_FIRST))
+		CLdrStreamCursor<const TFlashHeader, BFLAG_FILL> cursor(m_FileRawData, ApplicationStart);
+
+		do {
+			pHdr = cursor.GetHeader();
+			RawPointer = static_cast<uint32_t>(cursor.GetOffset());
+			if (appendinfoblock && !restructure && (pHdr != nullptr) && (pHdr->usFlags&BFLAG_FINAL))
 			{
-				RawPointer = DXEPointer;
+				retVal = PlanInfoBlock(journal, RawPointer, appinfoaddress);
 			}
-			else
+			const size_t SegmentStart = journal.GetOutputOffset(RawPointer);
+			CPatchCache::THash128 BlockKey;
+			const bool cacheable = (m_pCache != nullptr) && (pHdr != nullptr) && GetBlockKey(pHdr, BlockKey);
+			const std::vector<uint8_t>* cached = cacheable ? m_pCache->FindSegment(BlockKey) : nullptr;
+			const bool cachehit = cached != nullptr;
+			if (pHdr == nullptr)
 			{
-				break;
+				std::cerr << "Truncated block at offset 0x" << std::hex << cursor.GetOffset() << std::endl;
+				retVal = false;
 			}
-			DXEPointer += pHdr->Argument+sizeof(TFlashHeader);
-		} 
-
-		do {
-			pHdr = reinterpret_cast<TFlashHeader*>(&m_FileRawData[RawPointer]);
-			if ((((pHdr->usFlags&BK_ID) >> 24) == BK_THIS_ID) && CheckHeader(pHdr))
+			else if (cachehit)
+			{
+				//patched segment taken from the cache
+				retVal = journal.BeginEdit(CPatchJournal::CACHED_SEGMENT, RawPointer, cursor.GetNextOffset() - RawPointer);
+				journal.AppendView(cached->data(), cached->size());
+			}
+			else if ((((pHdr->usFlags&BK_ID) >> 24) == BK_THIS_ID) && CheckHeader(pHdr))
 			{
 				uint32_t pucAddr = pHdr->ulRamAddr;
 				uint32_t ulsize = pHdr->ulBlockLen;
@@ -839,27 +1678,15 @@ bool CElfReader::PatchFile(bool appendinfoblock, uint32_t appinfoaddress)
 
 					if (addblock)
 					{
-						for (size_t i = 0; i < sizeof(TFlashHeader); ++i)
-							m_PatchedData.push_back(m_FileRawData[RawPointer + i]);
+						//unchanged - copied from the source
 					}
 					else if (pHdr->ulRamAddr >= FlashLayoutCRCTable && pHdr->ulRamAddr+ulsize >= FlashLayoutCRCTable + 256 * sizeof(MemoryTable))
 					{
 						uint8_t *p = const_cast<uint8_t*>(GetMemoryContent(pHdr->ulRamAddr, pHdr->ulRamAddr + pHdr->ulBlockLen));
 						if (p!=nullptr)
 						{
-							uint32_t j = pHdr->ulRamAddr + pHdr->ulBlockLen;
-							for (uint32_t i = 0; i < (pHdr->ulBlockLen) / sizeof(pHdr->Argument); ++i)
-							{
-								bool equ = memcmp(&reinterpret_cast<uint32_t*>(p)[(pHdr->ulBlockLen) / sizeof(pHdr->Argument) - 1 - i], &pHdr->Argument, sizeof(pHdr->Argument)) == 0;
-								if (equ)
-								{
-									j -= sizeof(pHdr->Argument);
-								}
-								else
-								{
-									break;
-								}
-							}
+							//the trailing run of the fill pattern stays a fill block
+							const uint32_t j = pHdr->ulRamAddr + pHdr->ulBlockLen - static_cast<uint32_t>(CMemKernels::TrailingRun(p, pHdr->ulBlockLen, pHdr->Argument));
 
 							TFlashHeader newheader = *pHdr;
 							newheader.Argument = 0;
@@ -868,21 +1695,17 @@ bool CElfReader::PatchFile(bool appendinfoblock, uint32_t appinfoaddress)
 							newheader.usFlags &= ~BFLAG_FILL;
 							CalcHeaderChecksum(&newheader);
 
-							for (size_t i = 0; i < sizeof(TFlashHeader); ++i)
-								m_PatchedData.push_back(reinterpret_cast<uint8_t*>(&newheader)[i]);
+							retVal = journal.BeginEdit(CPatchJournal::SPLIT_FILL_BLOCK, RawPointer, sizeof(TFlashHeader));
+							journal.AppendLiteral(&newheader, sizeof(TFlashHeader));
 
-							uint8_t *pp = const_cast<uint8_t*>(GetMemoryContent(newheader.ulRamAddr, newheader.ulRamAddr + newheader.ulBlockLen));
-							for (size_t i = 0; i < newheader.ulBlockLen; ++i) {
-								m_PatchedData.push_back(pp[i]);
-							}
+							AppendMemoryContent(journal, GetMemoryContent(newheader.ulRamAddr, newheader.ulRamAddr + newheader.ulBlockLen), newheader.ulRamAddr, newheader.ulBlockLen);
 
 							TFlashHeader finalfillheader = *pHdr;
 							finalfillheader.ulRamAddr = j;
 							finalfillheader.ulBlockLen = pHdr->ulRamAddr + pHdr->ulBlockLen - j;
 							CalcHeaderChecksum(&finalfillheader);
 
-							for (size_t i = 0; i < sizeof(TFlashHeader); ++i)
-								m_PatchedData.push_back(reinterpret_cast<uint8_t*>(&finalfillheader)[i]);
+							journal.AppendLiteral(&finalfillheader, sizeof(TFlashHeader));
 
 						}
 						else
@@ -898,8 +1721,8 @@ bool CElfReader::PatchFile(bool appendinfoblock, uint32_t appinfoaddress)
 						uint8_t *p = const_cast<uint8_t*>(GetMemoryContent(pHdr->ulRamAddr, pHdr->ulRamAddr + pHdr->ulBlockLen));
 						if (p!=nullptr)
 						{
-							for (uint32_t i = 0; i < (FlashLayoutCRCTable - pHdr->ulRamAddr) / sizeof(pHdr->Argument); ++i)
-								retVal &= memcmp(&reinterpret_cast<uint32_t*>(p)[i], &pHdr->Argument, sizeof(pHdr->Argument))==0;
+							const uint32_t head = (FlashLayoutCRCTable - pHdr->ulRamAddr) & ~(sizeof(pHdr->Argument) - 1);
+							retVal = CMemKernels::LeadingRun(p, head, pHdr->Argument) == head;
 
 							if (retVal)
 							{
@@ -907,22 +1730,12 @@ bool CElfReader::PatchFile(bool appendinfoblock, uint32_t appinfoaddress)
 								header2modify.ulBlockLen = FlashLayoutCRCTable - pHdr->ulRamAddr;
 								uint8_t crcval = CalcHeaderChecksum(&header2modify);
 
-								for (size_t i = 0; i < sizeof(TFlashHeader); ++i)
-									m_PatchedData.push_back(reinterpret_cast<uint8_t*>(&header2modify)[i]);
+								retVal = journal.BeginEdit(CPatchJournal::SPLIT_FILL_BLOCK, RawPointer, sizeof(TFlashHeader));
+								journal.AppendLiteral(&header2modify, sizeof(TFlashHeader));
 
-								uint32_t j = pHdr->ulRamAddr + pHdr->ulBlockLen;
-								for (uint32_t i = 0; i < (FlashLayoutCRCTable - pHdr->ulRamAddr + pHdr->ulBlockLen) / sizeof(pHdr->Argument); ++i)
-								{
-									bool equ = memcmp(&reinterpret_cast<uint32_t*>(p)[(FlashLayoutCRCTable - pHdr->ulRamAddr + pHdr->ulBlockLen) / sizeof(pHdr->Argument) - 1 - i], &pHdr->Argument, sizeof(pHdr->Argument)) == 0;
-									if (equ)
-									{
-										j -= sizeof(pHdr->Argument);
-									}
-									else
-									{
-										break;
-									}
-								}
+								//the trailing run behind the table stays a fill block
+								const uint32_t tail = pHdr->ulRamAddr + pHdr->ulBlockLen - FlashLayoutCRCTable;
+								const uint32_t j = pHdr->ulRamAddr + pHdr->ulBlockLen - static_cast<uint32_t>(CMemKernels::TrailingRun(p + header2modify.ulBlockLen, tail, pHdr->Argument));
 
 								TFlashHeader newheader = header2modify;
 								newheader.Argument = 0;
@@ -931,20 +1744,15 @@ bool CElfReader::PatchFile(bool appendinfoblock, uint32_t appinfoaddress)
 								newheader.usFlags &= ~BFLAG_FILL;
 								CalcHeaderChecksum(&newheader);
 
-								for (size_t i = 0; i < sizeof(TFlashHeader); ++i)
-									m_PatchedData.push_back(reinterpret_cast<uint8_t*>(&newheader)[i]);
+								journal.AppendLiteral(&newheader, sizeof(TFlashHeader));
 
-								uint8_t *pp = const_cast<uint8_t*>(GetMemoryContent(newheader.ulRamAddr, newheader.ulRamAddr + newheader.ulBlockLen));
-								for (size_t i = 0; i < newheader.ulBlockLen; ++i) {
-									m_PatchedData.push_back(pp[i]);
-								}
+								AppendMemoryContent(journal, GetMemoryContent(newheader.ulRamAddr, newheader.ulRamAddr + newheader.ulBlockLen), newheader.ulRamAddr, newheader.ulBlockLen);
 								TFlashHeader finalfillheader = *&header2modify;
 								finalfillheader.ulRamAddr = j;
 								finalfillheader.ulBlockLen = pHdr->ulRamAddr+pHdr->ulBlockLen - j;
 								CalcHeaderChecksum(&finalfillheader);
 
-								for (size_t i = 0; i < sizeof(TFlashHeader); ++i)
-									m_PatchedData.push_back(reinterpret_cast<uint8_t*>(&finalfillheader)[i]);
+								journal.AppendLiteral(&finalfillheader, sizeof(TFlashHeader));
 							}
 							else
 							{
@@ -963,58 +1771,89 @@ bool CElfReader::PatchFile(bool appendinfoblock, uint32_t appinfoaddress)
 						std::cerr << "Corrupt fill block." << std::endl;
 						retVal = false;
 					}
-
-					RawPointer += FLASHHEADER_SIZE;
-					PrevHeaderId = -1;
 				}
 				else
 				{
 					bool addblock = true;
+					CMemKernels::TMismatch mismatch = { 0, ulsize, ulsize };
 
 					if (!(pHdr->usFlags&BFLAG_IGNORE))
 					{
 						if (ulsize > 0)
 						{
-							addblock = CmpDataBlock(pucAddr, ulsize, &m_FileRawData[RawPointer + FLASHHEADER_SIZE]);
+							addblock = CmpDataBlock(pucAddr, ulsize, &m_FileRawData[RawPointer + FLASHHEADER_SIZE], &mismatch, false);
 						}
 						if (!addblock)
 						{
-							std::cout << "Correction required (data block)" << std::hex << "0x" << pucAddr << std::endl;
+							std::cout << "Correction required (data block)" << std::hex << "0x" << pucAddr << " (0x" << mismatch.Count << " bytes in 0x" << pucAddr + mismatch.First << " - 0x" << pucAddr + mismatch.Stop << ")" << std::endl;
 						}
 					}
-					PrevHeaderId = m_PatchedData.size();
 					if (addblock)
 					{
-						for (size_t i = 0; i < sizeof(TFlashHeader); ++i)
-							m_PatchedData.push_back(m_FileRawData[RawPointer + i]);
-
-						for (size_t i = 0; i < ulsize; ++i)
-							m_PatchedData.push_back(m_FileRawData[RawPointer + FLASHHEADER_SIZE + i]);
+						//unchanged - copied from the source
 					}
 					else
 					{
-						for (size_t i = 0; i < sizeof(TFlashHeader); ++i)
-							m_PatchedData.push_back(m_FileRawData[RawPointer + i]);
-						const uint8_t *content = GetMemoryContent(pucAddr, pucAddr + ulsize);
-						for (size_t i = 0; i < ulsize; ++i)
-							m_PatchedData.push_back(content[i]);
+						//only the differing span is taken from the memory image
+						const uint32_t first = static_cast<uint32_t>(mismatch.First);
+						const uint32_t stop = static_cast<uint32_t>(mismatch.Stop);
+						retVal = journal.BeginEdit(CPatchJournal::REPLACE_RANGE, RawPointer + FLASHHEADER_SIZE + first, stop - first);
+						AppendMemoryContent(journal, GetMemoryContent(pucAddr + first, pucAddr + stop), pucAddr + first, stop - first);
 					}
-					RawPointer += FLASHHEADER_SIZE + pHdr->ulBlockLen;
 				}
 			}
 			else
 			{
 				retVal = false;
 			}
-		} while (((pHdr->usFlags&BFLAG_FINAL) == 0) && retVal);
+
+			if (cacheable && !cachehit && retVal)
+			{
+				segments.push_back({ BlockKey, SegmentStart, journal.GetOutputOffset(cursor.GetNextOffset()) - SegmentStart });
+			}
+			cursor.Next();
+		} while (retVal && ((pHdr->usFlags&BFLAG_FINAL) == 0));
 		if (!retVal)
 		{
 			m_PatchedData.clear();
 		}
         else
         {
-			DXEPointer = 0;
-			retVal = CorrectApplicationHeaderStructure(appendinfoblock, appinfoaddress, DXEPointer);
+			//the final block is the last one of the stream, the initial header depends on the final layout
+			retVal = journal.SetEnd(cursor.GetOffset()) && (restructure || PlanDxeArgument(journal, 0, journal.GetOutputSize()));
+			const size_t base = m_PatchedData.size();
+			m_PatchedData.reserve(base + journal.GetOutputSize());
+			CVectorSink sink(m_PatchedData);
+			retVal = retVal && journal.Apply(sink);
+			journal.PrintStatistics();
+			for (auto& segment : segments)
+			{
+				m_pCache->StoreSegment(segment.Key, m_PatchedData.data() + base + segment.Start, segment.Length);
+			}
+
+			if (m_bOptimizeFill && retVal)
+			{
+				retVal = OptimizeFillBlocks();
+			}
+			if (m_bMergeBlocks && retVal)
+			{
+				retVal = MergeSmallBlocks();
+			}
+			if (restructure)
+			{
+				//the header fixes are planned on the restructured stream
+				DXEPointer = 0;
+				retVal = retVal && CorrectApplicationHeaderStructure(appendinfoblock, appinfoaddress, DXEPointer);
+			}
+			if (retVal)
+			{
+				PrintStreamChecksums();
+			}
+			if (retVal && !restructure)
+			{
+				//kept for further outputs, the views refer to the memory image and the patch cache
+				m_pJournal = std::make_unique<CPatchJournal>(std::move(journal));
+			}
         }
 	}
 	else
@@ -1096,56 +1935,52 @@ bool CElfReader::ExtractMemoryLayout(bool usestatevectoraddress, uint32_t statev
 			}
 
 
+			//overwritten blocks and layout ranges are looked up by the interval engine, the decisions are the ones of the pairwise comparison
+			auto interval = [](const MemoryTable& entry) { return CIntervalEngine::TInterval{ reinterpret_cast<uint32_t>(entry.startaddress), reinterpret_cast<uint32_t>(entry.stopaddress) }; };
+			std::vector<CIntervalEngine::TInterval> blocks;
+			blocks.reserve(RegeneratedMemTable.size());
+			for (auto& value : RegeneratedMemTable)
+			{
+				blocks.push_back(interval(value));
+			}
+			const std::vector<uint32_t> overwrites = CIntervalEngine::FindOverwrites(blocks, sizeof(*RegeneratedMemTable[0].startaddress));
+			std::vector<CIntervalEngine::TInterval> ranges;
+			ranges.reserve(layout.size());
+			for (auto& value : layout)
+			{
+				ranges.push_back(interval(value));
+			}
+			CRangeIndex layoutindex(ranges);
+
 			std::vector<MemoryTable> t;
+			std::vector<CIntervalEngine::TInterval> overlapped;
 			for (std::vector<MemoryTable>::iterator it = RegeneratedMemTable.begin(); it != RegeneratedMemTable.end(); ++it) {
-				bool remove = false;
-				uint32_t cas = 0;
-				for (std::vector<MemoryTable>::reverse_iterator rit = RegeneratedMemTable.rbegin(); rit.base() - 1 != it; ++rit)
-				{
-					if (rit->stopaddress - rit->startaddress)//in this case it is a final block
-					{
-						if (it->startaddress >= rit->startaddress && it->startaddress < rit->stopaddress)
-						{
-							remove = true;
-							cas = 1;
-						}
-						else if (it->stopaddress > rit->startaddress && it->stopaddress < rit->stopaddress)
-						{
-							remove = true;
-							cas = 2;
-						}
-						else if (it->startaddress < rit->startaddress && it->stopaddress > rit->stopaddress)
-						{
-							remove = true;
-							cas = 3;
-						}
-					}
-				}
+				const uint32_t cas = overwrites[it - RegeneratedMemTable.begin()];
+				const bool remove = cas != 0;
 
 				if (remove)
 				{
 					std::cout << "Block: 0x" << it->startaddress << " 0x" << it->stopaddress << " removed (case " << cas << ")" << std::endl;
+					overlapped.push_back(interval(*it));
 				}
 				else
 				{
 					if (it->stopaddress - it->startaddress)
 					{
 						bool blockremoval = true;
-						for (auto & value : layout)
+						if (layoutindex.Contains(interval(*it)))
 						{
-							if ((value.startaddress) <= it->startaddress&&it->stopaddress <= value.stopaddress)
-							{
-								t.push_back(*it);
-								blockremoval = false;
-								break;
-							}
+							t.push_back(*it);
+							blockremoval = false;
 						}
 
 						if (blockremoval)
 						{
-							uint32_t cas;
-							for (auto & value : layout)
+							uint32_t adjustcase = 0;
+							const size_t index = layoutindex.FindOverlap(interval(*it));
+							if (index != CRangeIndex::NotFound)
 							{
+								MemoryTable& value = layout[index];
 								if ((value.startaddress) <= it->startaddress&&it->startaddress < value.stopaddress)
 								{
 									if (reinterpret_cast<long>(value.stopaddress) & 1)
@@ -1157,8 +1992,7 @@ bool CElfReader::ExtractMemoryLayout(bool usestatevectoraddress, uint32_t statev
 
 									t.push_back(*it);
 									blockremoval = false;
-									cas = 1;
-									break;
+									adjustcase = 1;
 								}
 								else if ((value.stopaddress) >= it->stopaddress&&it->stopaddress > value.startaddress)
 								{
@@ -1170,8 +2004,7 @@ bool CElfReader::ExtractMemoryLayout(bool usestatevectoraddress, uint32_t statev
 									it->startaddress = value.startaddress;
 									t.push_back(*it);
 									blockremoval = false;
-									cas = 2;
-									break;
+									adjustcase = 2;
 								}
 								else if (it->startaddress<value.startaddress&&it->stopaddress>=value.stopaddress)
 								{
@@ -1189,9 +2022,9 @@ bool CElfReader::ExtractMemoryLayout(bool usestatevectoraddress, uint32_t statev
 									it->stopaddress = value.stopaddress;
 									t.push_back(*it);
 									blockremoval = false;
-									cas = 3;
-									break;
+									adjustcase = 3;
 								}
+								layoutindex.Update(index, interval(value));
 							}
 
 							if (blockremoval)
@@ -1200,7 +2033,7 @@ bool CElfReader::ExtractMemoryLayout(bool usestatevectoraddress, uint32_t statev
 							}
 							else
 							{
-								std::cout << "Block range adjusted: 0x" << it->startaddress << " 0x" << it->stopaddress << " (case " << cas << ")" << std::endl;
+								std::cout << "Block range adjusted: 0x" << it->startaddress << " 0x" << it->stopaddress << " (case " << adjustcase << ")" << std::endl;
 							}
 						}
 
@@ -1215,6 +2048,20 @@ bool CElfReader::ExtractMemoryLayout(bool usestatevectoraddress, uint32_t statev
 			std::cout << "Overall number of blocks " << std::dec << RegeneratedMemTable.size() << "(dec)" << std::endl;
 			RegeneratedMemTable = t;
 			std::cout << "Number of blocks after removal " << std::dec << RegeneratedMemTable.size() << "(dec)" << std::endl;
+			if (m_u32CrcPackEntries > 0)
+			{
+				//the layout ranges as adjusted above
+				ranges.clear();
+				for (auto& value : layout)
+				{
+					ranges.push_back(interval(value));
+				}
+				PackMemTable(ranges);
+			}
+			if (m_u32CrcBudget > 0)
+			{
+				PartitionMemTable();
+			}
 			std::cout << std::hex;
 
 
@@ -1250,14 +2097,17 @@ bool CElfReader::ExtractMemoryLayout(bool usestatevectoraddress, uint32_t statev
 			uint32_t blockno = 1;
 			uint32_t crcix = 0;
 			uint32_t sizechecked = 0;
+			bool tablewritten = false;
 			retVal = true;
 
+			//CRCs first (in parallel), the table is reported in order afterwards
+			CalcMemTableCrc();
+
 			for (auto& value : RegeneratedMemTable) {
 				//std::cout << "Block Number: " << std::hex << std::setfill('0') << std::setw(2) << blockno++ << " " << "Block start: 0x" << value.startaddress << " " << "Block stop: 0x" << value.stopaddress << std::endl;
 				const uint8_t* d = GetMemoryContent(reinterpret_cast<uint32_t>(value.startaddress), reinterpret_cast<uint32_t>(value.stopaddress));
 				if (d != nullptr)
 				{
-					value.m_u16CRC = g_CalcCrcSum(CRCSeed, (value.stopaddress - value.startaddress) * sizeof(*value.startaddress), d);
 					std::string bstat = value.m_bDMAAccess == false ? "false" : "true";
 					if (blockno)
 					{
@@ -1278,36 +2128,7 @@ bool CElfReader::ExtractMemoryLayout(bool usestatevectoraddress, uint32_t statev
 						}
 					}
 
-					//update memory content
-					MemoryTable* mem = reinterpret_cast<MemoryTable*>(&dummy[FlashLayoutCRCTable - m_MemoryLayout[0].OffsetCompensation]);
-					size_t i = 0;
-					for (auto& value : RegeneratedMemTable) {
-						value.m_pu16CRCState = &reinterpret_cast<uint16_t*>(statevectoraddress)[i];
-						mem[i++] = value;
-					}
-
-					if (i > 0)
-					{
-						const uint32_t tablesize = sizeof(MemoryTable);
-						mem[--i].m_NextTableEntry = reinterpret_cast<MemoryTable*>(FlashLayoutCRCTable);
-						while (i > 0)
-						{
-							uint32_t address = FlashLayoutCRCTable + i * sizeof(MemoryTable);
-							mem[i - 1].m_NextTableEntry = reinterpret_cast<MemoryTable*>(address);
-							--i;
-						}
-
-					}
-					else
-					{
-						mem[0].m_bDMAAccess = false;
-						mem[0].m_NextTableEntry = reinterpret_cast<MemoryTable*>(FlashLayoutCRCTable);
-						mem[0].m_pu16CRCState = 0;
-						mem[0].startaddress = 0;
-						mem[0].stopaddress = 0;
-						mem[0].m_u16CRC = 0xFFFF;
-						std::cout << "No section found. Deactivate CRC checking." << std::endl;
-					}
+					tablewritten = true;
 #ifdef _DEBUG_
 					if (reinterpret_cast<uint32_t>(value.startaddress) >= 0 && reinterpret_cast<uint32_t>(value.stopaddress) <= SDRAMSize)
 					{
@@ -1339,9 +2160,29 @@ bool CElfReader::ExtractMemoryLayout(bool usestatevectoraddress, uint32_t statev
 				}
 			}
 
+			if (tablewritten)
+			{
+				//the table is serialized once, after all CRCs are known
+				std::vector<CDescriptorTable::TEntry> entries;
+				entries.reserve(RegeneratedMemTable.size());
+				for (size_t i = 0; i < RegeneratedMemTable.size(); ++i)
+				{
+					MemoryTable& value = RegeneratedMemTable[i];
+					value.m_pu16CRCState = &reinterpret_cast<uint16_t*>(statevectoraddress)[i];
+					CDescriptorTable::TEntry entry = { reinterpret_cast<uint32_t>(value.startaddress), reinterpret_cast<uint32_t>(value.stopaddress), value.m_u16CRC, value.m_bDMAAccess };
+					entries.push_back(entry);
+				}
+				m_DescriptorTable.Build(entries, FlashLayoutCRCTable, statevectoraddress);
+				WriteDescriptorTable();
+			}
+
 			if (retVal)
 			{
 				std::cout << std::dec << "Length of stream: " << m_StreamLength << "(dec) Bytes " << "Code/const data size: " << sizechecked << "(dec) " << "Percentage of stream being checked= " << 100.0 * sizechecked / m_StreamLength << " %" << std::endl;
+				if (m_bCoverageReport)
+				{
+					ReportCoverage(overlapped);
+				}
 				if (RegeneratedMemTable.size() <= sizeof(m_MemoryTable) / sizeof(m_MemoryTable[0]))
 				{
 					std::cout << std::dec << "No. of CRC vector table entries: " << RegeneratedMemTable.size() << " out of " << sizeof(m_MemoryTable) / sizeof(m_MemoryTable[0]) << ". Remaining table size: " << (sizeof(m_MemoryTable) / sizeof(m_MemoryTable[0])) - RegeneratedMemTable.size() << " entries." << std::endl;
@@ -1468,27 +2309,48 @@ bool CElfReader::Merge(std::string patcheldrfile, uint32_t baseaddress)
 
 	std::fstream elffile;
 	std::streampos begin, end;
-	elffile.open(patcheldrfile, std::ios_base::out | std::ios_base::trunc);
+	//binary - the line ends are written by the digest stream buffer
+	elffile.open(patcheldrfile, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
 
 	uint32_t linecount = 0;
 	bool retVal = true;
+	const bool reuse = m_bReuseHexRecords && CanReuseHexRecords(baseaddress);
 	if (elffile.is_open())
 	{
+		//the digests of the hex text are calculated while it is written
+		CDigestStreamBuf hexdigest(elffile.rdbuf(), CDigestStreamBuf::NativeCrLf);
+		std::ostream hexfile(&hexdigest);
+		//with reused records all data records are written here, the encoder below has nothing left to do
 		std::vector<uint8_t>::iterator iter = m_PatchedData.begin();
+		if (reuse)
+		{
+			linecount += WriteReusedHex(hexfile, base);
+			iter = m_PatchedData.end();
+		}
 		uint32_t addresscounter = base;
+		CLdrStreamCursor<const TFlashHeader, BFLAG_FILL> cursor(m_PatchedData);
 
 		//the end? Then our task is quite simple (we are done) 
 		if (iter != m_PatchedData.end())
 		{
 			uint32 mask = 0xFFFF0000u;
 			std::string dummy = SetExtendedAddress(base&mask);
-			elffile << dummy;
+			hexfile << dummy;
 			linecount++;
 		}
 
 		//that is special at the beginning. We start with zero (that is the reason why it is outside the loop)
 		while (iter!=m_PatchedData.end()){
 			
+				//the cursor validates the block (header and payload inside the stream) before its bytes are read
+				const TFlashHeader *pBlock = cursor.GetHeader();
+				if ((pBlock == nullptr) || (cursor.GetOffset() != static_cast<size_t>(iter - m_PatchedData.begin())))
+				{
+					std::cerr << "Invalid data stream. Truncated block at offset 0x" << std::hex << (iter - m_PatchedData.begin()) << std::endl;
+					retVal = false;
+					break;
+				}
+				cursor.Next();
 				uint8_t buffer[32];
 				uint32_t offset = 0;
 				for (i = 0; i < sizeof(TFlashHeader); ++i)
@@ -1502,25 +2364,25 @@ bool CElfReader::Merge(std::string patcheldrfile, uint32_t baseaddress)
 						const uint8_t bytecount = i+1;	//length
 						const uint8_t datatype = 0x0;	//Extended Linear Address
 						uint8_t crc = CalcCRC(bytecount, static_cast<uint16_t>(addresscounter & 0xFFFF), datatype, reinterpret_cast<uint8_t*>(&buffer));
-						elffile << ":" << std::hex << std::uppercase << std::setfill('0') << std::setw(2) << static_cast<uint32_t>(bytecount) << std::setw(4) << static_cast<uint16_t>(addresscounter & 0xFFFF) << std::setw(2) << static_cast<uint32_t>(datatype);
+						hexfile << ":" << std::hex << std::uppercase << std::setfill('0') << std::setw(2) << static_cast<uint32_t>(bytecount) << std::setw(4) << static_cast<uint16_t>(addresscounter & 0xFFFF) << std::setw(2) << static_cast<uint32_t>(datatype);
 						for (uint32_t k = 0; k <= i; k++)
 						{
-							elffile << std::hex << std::uppercase << std::setw(2) << static_cast<uint32_t>(buffer[k]);
+							hexfile << std::hex << std::uppercase << std::setw(2) << static_cast<uint32_t>(buffer[k]);
 						}
-						elffile << std::hex << std::uppercase << std::setw(2) << static_cast<uint32_t>(crc) << std::endl;
+						hexfile << std::hex << std::uppercase << std::setw(2) << static_cast<uint32_t>(crc) << std::endl;
 						linecount++;
 
-						elffile << dummy;
+						hexfile << dummy;
 						linecount++;
 						offset = i+1;
 						addresscounter += i+1;
 					}
 				}
 
-				uint32_t blocksize = reinterpret_cast<TFlashHeader*>(buffer)->ulBlockLen;
+				uint32_t blocksize = pBlock->ulBlockLen;
 				uint32_t totalsize = blocksize + sizeof(TFlashHeader);
 
-				if (!(reinterpret_cast<TFlashHeader*>(buffer)->usFlags&BFLAG_FILL))
+				if (!(pBlock->usFlags&BFLAG_FILL))
 				{
 					//are there additional bytes to write?
 					if (totalsize != offset)
@@ -1539,12 +2401,12 @@ bool CElfReader::Merge(std::string patcheldrfile, uint32_t baseaddress)
 							const uint8_t bytecount = i - offset;	//length
 							const uint8_t datatype = 0x0;	//Extended Linear Address
 							uint8_t crc = CalcCRC(bytecount, static_cast<uint16_t>(addresscounter & 0xFFFF), datatype, reinterpret_cast<uint8_t*>(&buffer[offset]));
-							elffile << ":" << std::hex << std::uppercase << std::setfill('0') << std::setw(2) << static_cast<uint32_t>(bytecount) << std::setw(4) << static_cast<uint16_t>(addresscounter & 0xFFFF) << std::setw(2) << static_cast<uint32_t>(datatype);
+							hexfile << ":" << std::hex << std::uppercase << std::setfill('0') << std::setw(2) << static_cast<uint32_t>(bytecount) << std::setw(4) << static_cast<uint16_t>(addresscounter & 0xFFFF) << std::setw(2) << static_cast<uint32_t>(datatype);
 							for (uint32_t k = offset; k < i; k++)
 							{
-								elffile << std::hex << std::uppercase << std::setw(2) << static_cast<uint32_t>(buffer[k]);
+								hexfile << std::hex << std::uppercase << std::setw(2) << static_cast<uint32_t>(buffer[k]);
 							}
-							elffile << std::hex << std::uppercase << std::setw(2) << static_cast<uint32_t>(crc) << std::endl;
+							hexfile << std::hex << std::uppercase << std::setw(2) << static_cast<uint32_t>(crc) << std::endl;
 							addresscounter += i - offset;
 							totalsize -= i;
 							i = 0;
@@ -1552,7 +2414,7 @@ bool CElfReader::Merge(std::string patcheldrfile, uint32_t baseaddress)
 							if (!(j & 0xFFFF) && i < totalsize)
 							{
 								std::string dummy = SetExtendedAddress(addresscounter);
-								elffile << dummy;
+								hexfile << dummy;
 								linecount++;
 								bSetExtendedAddress = true;
 							}
@@ -1583,12 +2445,12 @@ bool CElfReader::Merge(std::string patcheldrfile, uint32_t baseaddress)
 						uint8_t datatype = 0x00;			//Extended Linear Address
 
 						uint8_t crc = CalcCRC(bytecount, static_cast<uint16_t>(addresscounter & 0xFFFF), datatype, reinterpret_cast<uint8_t*>(&buffer[offset]));
-						elffile << ":" << std::hex << std::uppercase << std::setfill('0') << std::setw(2) << static_cast<uint32_t>(bytecount) << std::setw(4) << static_cast<uint16_t>(addresscounter & 0xFFFF) << std::setw(2) << static_cast<uint32_t>(datatype);
+						hexfile << ":" << std::hex << std::uppercase << std::setfill('0') << std::setw(2) << static_cast<uint32_t>(bytecount) << std::setw(4) << static_cast<uint16_t>(addresscounter & 0xFFFF) << std::setw(2) << static_cast<uint32_t>(datatype);
 						for (uint32_t k = offset; k < i; k++)
 						{
-							elffile << std::hex << std::uppercase << std::setw(2) << static_cast<uint32_t>(buffer[k]);
+							hexfile << std::hex << std::uppercase << std::setw(2) << static_cast<uint32_t>(buffer[k]);
 						}
-						elffile << std::hex << std::uppercase << std::setw(2) << static_cast<uint32_t>(crc) << std::endl;
+						hexfile << std::hex << std::uppercase << std::setw(2) << static_cast<uint32_t>(crc) << std::endl;
 
 						addresscounter += i - offset;
 
@@ -1610,10 +2472,25 @@ bool CElfReader::Merge(std::string patcheldrfile, uint32_t baseaddress)
 				if (!(j & 0xFFFF) && (iter+1)!=m_PatchedData.end())
 				{
 					std::string dummy = SetExtendedAddress(addresscounter);
-					elffile << dummy;
+					hexfile << dummy;
 				}
 		}
-		elffile << ":00000001FF" << std::endl;
+		hexfile << ":00000001FF" << std::endl;
+		hexfile.flush();
+		elffile.flush();
+		//the digest stream buffer writes with sputn, a short write only shows up on hexfile
+		const bool written = hexfile.good() && elffile.good();
+		if (!written)
+		{
+			std::cerr << "Unable to write " << patcheldrfile << std::endl;
+		}
+		retVal = retVal && written;
+		if (retVal)
+		{
+			CDigest streamdigest;
+			streamdigest.Update(m_PatchedData.data(), m_PatchedData.size());
+			retVal = CDigest::WriteManifest(patcheldrfile + ".manifest", patcheldrfile, { { "stream", &streamdigest }, { "hex", &hexdigest.GetDigest() } });
+		}
 	}
 	else
 	{
@@ -1628,39 +2505,21 @@ uint32_t CElfReader::FindBlock(uint32_t address)
 	uint32_t retVal=-1;
 	if (eElfStatus == ELF_OK)
 	{
-		TFlashHeader *pHdr;
-		uint32_t RawPointer = 0;
-		do {
-			pHdr = reinterpret_cast<TFlashHeader*>(&m_FileRawData[RawPointer]);
-			if ((((pHdr->usFlags&BK_ID) >> 24) == BK_THIS_ID) && CheckHeader(pHdr))
+		CLdrStreamCursor<const TFlashHeader, BFLAG_FILL> cursor(m_FileRawData);
+		const TFlashHeader *pHdr = cursor.GetHeader();
+		while ((pHdr != nullptr) && (((pHdr->usFlags&BK_ID) >> 24) == BK_THIS_ID) && CheckHeader(pHdr))
+		{
+			if ((pHdr->usFlags&BFLAG_IGNORE) == 0x00)
 			{
-				uint32_t pucAddr;
-				uint32_t ulsize;
-				uint32_t RRawPointer;
-				if (pHdr->usFlags&BFLAG_FILL)
-				{
-					pucAddr = pHdr->ulRamAddr;
-					ulsize = pHdr->ulBlockLen;
-					RRawPointer = RawPointer;
-					RawPointer += FLASHHEADER_SIZE;
-				}
-				else
+				if (address >= pHdr->ulRamAddr && address < pHdr->ulRamAddr + pHdr->ulBlockLen)
 				{
-					pucAddr = pHdr->ulRamAddr;
-					ulsize = pHdr->ulBlockLen;
-					RRawPointer = RawPointer+FLASHHEADER_SIZE;
-					RawPointer += FLASHHEADER_SIZE + pHdr->ulBlockLen;
-				}
-
-				if ((pHdr->usFlags&BFLAG_IGNORE) == 0x00)
-				{
-					if (address >= pucAddr && address < pucAddr + pHdr->ulBlockLen)
-					{
-						retVal = RRawPointer+address-pHdr->ulRamAddr;
-					}
+					//fill blocks don't carry a payload -> offset of the header
+					const size_t RRawPointer = (pHdr->usFlags&BFLAG_FILL) ? cursor.GetOffset() : cursor.GetPayloadOffset();
+					retVal = static_cast<uint32_t>(RRawPointer) + address - pHdr->ulRamAddr;
 				}
 			}
-		} while (((pHdr->usFlags&BFLAG_FINAL) == 0));
+			pHdr = (pHdr->usFlags&BFLAG_FINAL) ? nullptr : cursor.Next();
+		}
 	}
 	else
 	{
@@ -1690,17 +2549,137 @@ std::vector<CIntelHexMerger*> CElfReader::FindBlockinLdr(uint32_t startaddress,
 	return j;
 }
 
+bool CElfReader::CanReuseHexRecords(uint32_t baseaddress) const
+{
+	//the data records of the original file have to hold the stream in order, starting at the base address.
+	//Records below the base address (DXEs in front of the application) aren't part of the patched stream.
+	//Reused lines keep their 16 bit offset and are written behind extended linear address records, so
+	//segment address records (type 02) can't be reused.
+	uint64_t offset = 0;
+	bool retVal = !m_Merger.empty();
+	for (auto it = m_Merger.begin(); retVal && (it != m_Merger.end()); ++it)
+	{
+		if (it->HexLine.DataType == 0x00)
+		{
+			const uint64_t address = it->HexLine.RecordOffset;
+			if ((offset == 0) && (address + it->HexLine.RecordLength <= baseaddress))
+			{
+				continue;
+			}
+			retVal = (address == baseaddress + offset) && (it->HexLine.u8DataLine.size() == it->HexLine.RecordLength);
+			offset += it->HexLine.RecordLength;
+		}
+		else
+		{
+			retVal = it->HexLine.DataType != 0x02;
+		}
+	}
+	if (!retVal)
+	{
+		std::cout << "Records of the original file don't map to the stream at 0x" << std::hex << baseaddress << std::dec << ", the hex file is encoded completely." << std::endl;
+	}
+	return retVal;
+}
+
+void CElfReader::WriteHexRecord(std::ostream& hexfile, uint32_t address, uint8_t type, const uint8_t* data, uint8_t length) const
+{
+	static const char Digits[] = "0123456789ABCDEF";
+	char line[1 + 2 * (4 + 0xFF + 1) + 1];
+	char* p = line;
+	uint8_t crc = length + static_cast<uint8_t>(address & 0xFF) + static_cast<uint8_t>((address >> 8) & 0xFF) + type;
+	const uint8_t prefix[] = { length, static_cast<uint8_t>((address >> 8) & 0xFF), static_cast<uint8_t>(address & 0xFF), type };
+	*p++ = ':';
+	for (uint8_t byte : prefix)
+	{
+		*p++ = Digits[byte >> 4];
+		*p++ = Digits[byte & 0x0F];
+	}
+	for (uint32_t i = 0; i < length; ++i)
+	{
+		crc += data[i];
+		*p++ = Digits[data[i] >> 4];
+		*p++ = Digits[data[i] & 0x0F];
+	}
+	crc = (~crc) + 1;
+	*p++ = Digits[crc >> 4];
+	*p++ = Digits[crc & 0x0F];
+	*p++ = '\n';
+	hexfile.write(line, p - line);
+}
+
+uint32_t CElfReader::WriteReusedHex(std::ostream& hexfile, uint32_t baseaddress)
+{
+	//records whose bytes are unchanged are copied as text, changed records are encoded with the same address and
+	//length, so the layout of the original file is kept. After an inserted or removed block the records don't match
+	//any more and the rest of the stream is encoded along the original record grid.
+	uint32_t linecount = 0;
+	uint32_t reused = 0;
+	uint32_t encoded = 0;
+	uint32_t segment = 0;
+	bool segmentvalid = false;
+	size_t offset = 0;
+	const size_t size = m_PatchedData.size();
+	auto setsegment = [&](uint32_t address)
+	{
+		if (!segmentvalid || ((address >> 16) != segment))
+		{
+			segment = address >> 16;
+			segmentvalid = true;
+			const uint8_t data[] = { static_cast<uint8_t>(segment >> 8), static_cast<uint8_t>(segment & 0xFF) };
+			WriteHexRecord(hexfile, 0, 0x04, data, sizeof(data));
+			linecount++;
+		}
+	};
+	for (auto it = m_Merger.begin(); (it != m_Merger.end()) && (offset < size); ++it)
+	{
+		//records below the base address were checked to lie in front of the stream
+		if ((it->HexLine.DataType == 0x00) && (it->HexLine.RecordOffset >= baseaddress))
+		{
+			const std::vector<uint8_t>& original = it->HexLine.u8DataLine;
+			const size_t length = std::min(original.size(), size - offset);
+			const uint32_t address = baseaddress + static_cast<uint32_t>(offset);
+			setsegment(address);
+			if ((length == original.size()) && (memcmp(original.data(), m_PatchedData.data() + offset, length) == 0))
+			{
+				hexfile.write(it->HexLine.cDataLine.data(), it->HexLine.cDataLine.size());
+				hexfile.put('\n');
+				reused++;
+			}
+			else
+			{
+				WriteHexRecord(hexfile, address, 0x00, m_PatchedData.data() + offset, static_cast<uint8_t>(length));
+				encoded++;
+			}
+			linecount++;
+			offset += length;
+		}
+	}
+	//the stream grew: records of 32 bytes that don't cross a 64K boundary
+	while (offset < size)
+	{
+		const uint32_t address = baseaddress + static_cast<uint32_t>(offset);
+		const size_t length = std::min<size_t>({ 0x20, size - offset, 0x10000 - (address & 0xFFFF) });
+		setsegment(address);
+		WriteHexRecord(hexfile, address, 0x00, m_PatchedData.data() + offset, static_cast<uint8_t>(length));
+		encoded++;
+		linecount++;
+		offset += length;
+	}
+	std::cout << std::dec << "Hex output: " << reused << " records reused, " << encoded << " records encoded." << std::endl;
+	return linecount;
+}
+
 bool CElfReader::SimulateExtraction(std::vector<uint8_t> rawdata)
 {
 	bool retVal;
 	if (eElfStatus == ELF_OK)
 	{
-		TFlashHeader *pHdr;
-		uint32_t RawPointer = 0;
+		CLdrStreamCursor<const TFlashHeader, BFLAG_FILL> cursor(rawdata);
+		const TFlashHeader *pHdr;
 		retVal = true;
 		do {
-			pHdr = reinterpret_cast<TFlashHeader*>(&rawdata[RawPointer]);
-			if ((((pHdr->usFlags&BK_ID) >> 24) == BK_THIS_ID) && CheckHeader(pHdr))
+			pHdr = cursor.GetHeader();
+			if ((pHdr != nullptr) && (((pHdr->usFlags&BK_ID) >> 24) == BK_THIS_ID) && CheckHeader(pHdr))
 			{
 				if (pHdr->usFlags&BFLAG_FILL)
 				{
@@ -1708,22 +2687,28 @@ bool CElfReader::SimulateExtraction(std::vector<uint8_t> rawdata)
 					uint32_t ulsize = pHdr->ulBlockLen;
 					std::cout << "Verifying fill block\tAddress: 0x" << std::hex << pucAddr << "\tSize: 0x" << std::hex << ulsize << std::endl;
 
-					if (!(pHdr->usFlags&BFLAG_IGNORE))
-						retVal &= CmpFillBlock(pucAddr, ulsize, pHdr->Argument);
+					CMemKernels::TMismatch mismatch;
+					if (!(pHdr->usFlags&BFLAG_IGNORE) && !CmpFillBlock(pucAddr, ulsize, pHdr->Argument, &mismatch))
+					{
+						std::cerr << "Fill block differs at 0x" << std::hex << pucAddr + mismatch.First << std::endl;
+						retVal = false;
+					}
 
-					RawPointer += FLASHHEADER_SIZE;
 				}
 				else
 				{
 					uint32_t pucAddr = pHdr->ulRamAddr;
-					uint32_t RawPointerAdd = RawPointer + FLASHHEADER_SIZE;
+					uint32_t RawPointerAdd = cursor.GetPayloadOffset();
 					uint32_t ulsize = pHdr->ulBlockLen;
 					std::cout << "Verifying code/data block\tAddress: 0x" << std::hex << pucAddr << "\tSize: 0x" << std::hex << ulsize << std::endl;
 
-					if (!(pHdr->usFlags&BFLAG_IGNORE)&&ulsize>0)
-						retVal &= CmpDataBlock(pucAddr, ulsize, &rawdata[RawPointer + FLASHHEADER_SIZE]);
+					CMemKernels::TMismatch mismatch;
+					if (!(pHdr->usFlags&BFLAG_IGNORE) && ulsize > 0 && !CmpDataBlock(pucAddr, ulsize, cursor.GetPayload(), &mismatch))
+					{
+						std::cerr << "Code/data block differs at 0x" << std::hex << pucAddr + mismatch.First << std::endl;
+						retVal = false;
+					}
 					
-					RawPointer += FLASHHEADER_SIZE + pHdr->ulBlockLen;
 				}
 
 				if ((pHdr->usFlags&(BFLAG_INIT | BFLAG_IGNORE)) == BFLAG_INIT)
@@ -1735,13 +2720,19 @@ bool CElfReader::SimulateExtraction(std::vector<uint8_t> rawdata)
 				{
 					std::cout << "Simulate callback execution" << std::endl;
 				}
+				cursor.Next();
+			}
+			else if (pHdr == nullptr)
+			{
+				retVal = false;
+				std::cerr << "Truncated block at offset 0x" << std::hex << cursor.GetOffset() << std::endl;
 			}
 			else
 			{
 				retVal = false;
 				std::cerr << "Abnormal header block." << std::endl;
 			}
-		} while (((pHdr->usFlags&BFLAG_FINAL) == 0) && retVal);
+		} while (retVal && ((pHdr->usFlags&BFLAG_FINAL) == 0));
 	}
 	else
 	{
@@ -1823,30 +2814,26 @@ void CElfReader::PrintHeader(TFlashHeader const* pHeader, size_t address) const
 bool CElfReader::PrintFileTree(bool patchedfile) const
 {
 	const std::vector<uint8_t>& surrogate = patchedfile ? m_PatchedData : m_FileRawData;
-	std::vector<uint8_t>::const_iterator pRaw = surrogate.cbegin();
+	CLdrStreamCursor<const TFlashHeader, BFLAG_FILL> cursor(surrogate);
 
-	while (std::distance(surrogate.begin(), pRaw) + sizeof(TFlashHeader) < surrogate.size())
+	for (TFlashHeader const* pHeader = cursor.GetHeader(); pHeader != nullptr; pHeader = cursor.Next())
 	{
-		TFlashHeader const* pHeader = reinterpret_cast<TFlashHeader const*>(&pRaw[0]);
 		if (pHeader->usFlags & BFLAG_FIRST)
 		{
-			PrintNextApplicationHeader(pHeader, std::distance(surrogate.begin(), pRaw));
+			PrintNextApplicationHeader(pHeader, cursor.GetOffset());
 		}
 		else
 		{
-			PrintHeader(pHeader, std::distance(surrogate.begin(), pRaw));
+			PrintHeader(pHeader, cursor.GetOffset());
 		}
-		//if (pHeader->usFlags & BFLAG_FINAL)
-			//break;
-
-		pRaw += sizeof(TFlashHeader);
+	}
 
-		if (!(pHeader->usFlags & BFLAG_FILL))
-		{
-			pRaw += pHeader->ulBlockLen;
-		}
+	const bool retVal = cursor.GetOffset() == surrogate.size();
+	if (!retVal)
+	{
+		std::cerr << "Truncated block at offset 0x" << std::hex << cursor.GetOffset() << std::endl;
 	}
-	return true;
+	return retVal;
 }
 
 bool CElfReader::CheckIntegrity(std::string filename)
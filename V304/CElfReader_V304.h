@@ -1,7 +1,17 @@
 #pragma once
 #include <string>
+#include <iosfwd>
 #include <vector>
 #include <cstdint>
+#include <memory>
+#include "..\BootTimeEstimator.h"
+#include "..\PatchCache.h"
+#include "..\CrcMemo.h"
+#include "..\DescriptorTable.h"
+#include "..\IntervalEngine.h"
+#include "..\CoverageMap.h"
+#include "..\PatchJournal.h"
+#include "..\MemKernels.h"
 namespace V304
 {
 	class CIntelHexConverter
@@ -49,6 +59,8 @@ namespace V304
 		static const uint32_t FlashLayoutLoc = 0x81ff8100;
 		static const uint32_t FlashLayoutCRCTable = 0x81ff8400;
 		static const uint16_t CRCSeed = 0xFFFF;
+		static const uint32_t MinFillRunLength = 2 * 16 + 4;	//a split costs two additional headers
+		static const uint32_t MaxMergedBlockLength = 0x10000;
 		static const uint32_t IgnoreSDRAMLower = 0x81ff8000;
 		static const uint32_t IgnoreSDRAMUpper = 0x81ffffff;
 		/** Structure of block headers in flash memory */
@@ -116,8 +128,22 @@ namespace V304
 		std::vector<uint8_t> m_PatchedData;
 		ElfStatus eElfStatus;
 		size_t	m_StreamLength;
+		bool	m_bOptimizeFill;
+		uint32_t m_u32MinFillRun;
+		bool	m_bMergeBlocks;
+		uint32_t m_u32MaxMergedBlock;
+		uint32_t m_u32CrcBudget;
+		uint32_t m_u32CrcPackEntries;
+		bool	m_bCoverageReport;
+		bool	m_bReuseHexRecords;
+		CPatchCache* m_pCache;
+		CCrcMemo* m_pCrcMemo;
+		CDescriptorTable m_DescriptorTable;
+		std::unique_ptr<CPatchJournal> m_pJournal;	/**< edits of the last PatchFile, nullptr if the stream was restructured afterwards */
+		std::vector<CIntervalEngine::TInterval> m_LoadedBlocks;	/**< memory written by the stream (Deflate) */
+		std::vector<bool> m_LoadedFill;							/**< the loaded block is a fill block */
 
-		bool	CheckHeader(TFlashHeader* header);
+		bool	CheckHeader(const TFlashHeader* header) const;
 		bool    CreateHeader(TFlashHeader* header, uint32_t flags, uint32_t targetaddress, uint32_t bytecount, uint32_t argument);
 		bool	FillMemory(uint32_t address, uint32_t length, uint32_t pattern = 0x00);
 		bool	CopyBlock(uint32_t sourceaddress, uint32_t destaddress, uint32_t length);
@@ -126,32 +152,86 @@ namespace V304
 		const uint8_t* GetMemoryContent(uint32_t start, uint32_t stop)const;
 		bool	RequiresDMAAccess(uint32_t start, uint32_t stop)const;
 		bool	IgnoreMemorySection(uint32_t start, uint32_t stop)const;
+		int		GetMemoryRegion(uint32_t start, uint32_t stop)const;
+		uint32_t FindApplicationStart() const;
+		void	CalcMemTableCrc();
+		void	PartitionMemTable();
+		void	PackMemTable(const std::vector<CIntervalEngine::TInterval>& layout);
+		void	ReportCoverage(const std::vector<CIntervalEngine::TInterval>& overlapped) const;
+		void	WriteDescriptorTable();
+		void	AppendMemoryContent(CPatchJournal& journal, const uint8_t* content, uint32_t address, uint32_t length) const;
+		std::vector<MemoryTable> PartitionEntries(const std::vector<MemoryTable>& table, uint32_t budget) const;
+		bool	GetBlockKey(const TFlashHeader* header, CPatchCache::THash128& key) const;
+		bool	AccumulateBootTime(const std::vector<uint8_t>& stream, size_t RawPointer, const CBootTimeEstimator& estimator, CBootTimeEstimator::TBootTime& time) const;
 		std::string
 			SetExtendedAddress(uint32_t address);
 
 		uint32_t FindBlock(uint32_t address);
 		std::vector<CIntelHexMerger*> FindBlockinLdr(uint32_t startaddress, uint32_t stopaddress);
+		/** the data records of the original file hold the stream at baseaddress in order */
+		bool	CanReuseHexRecords(uint32_t baseaddress) const;
+		/** writes the data records of the patched stream (unchanged records as original text), returns the line count */
+		uint32_t WriteReusedHex(std::ostream& hexfile, uint32_t baseaddress);
+		void	WriteHexRecord(std::ostream& hexfile, uint32_t address, uint8_t type, const uint8_t* data, uint8_t length) const;
 
 		bool	CorrectApplicationHeaderStructure(bool appendinfoblock, uint32_t appinfoaddress, uint32_t DXEPointer);
-		bool	CmpFillBlock(uint32_t address, uint32_t size, uint32_t pattern);
-		bool	CmpDataBlock(uint32_t address, uint32_t size, uint8_t* data);
+		/** IGNORE block with the application info in front of the final block at offset (source of the journal) */
+		bool	PlanInfoBlock(CPatchJournal& journal, size_t offset, uint32_t appinfoaddress);
+		/** argument of the initial header at offset (output of the journal), length of the DXE including that header */
+		bool	PlanDxeArgument(CPatchJournal& journal, size_t offset, size_t length);
+		/** the mismatch is reported if requested, earlyexit stops at the first one */
+		bool	CmpFillBlock(uint32_t address, uint32_t size, uint32_t pattern, CMemKernels::TMismatch* mismatch = nullptr, bool earlyexit = true);
+		bool	CmpDataBlock(uint32_t address, uint32_t size, const uint8_t* data, CMemKernels::TMismatch* mismatch = nullptr, bool earlyexit = true);
 		bool	PatchSection(std::vector<uint8_t>& datavector, TFlashHeader* header);
+		bool	OptimizeFillBlocks();
+		void	AppendFillHeader(std::vector<uint8_t>& datavector, TFlashHeader header, size_t& lastfill, uint32_t& mergedfills);
+		bool	MergeSmallBlocks();
 		bool	SimulateExtraction(std::vector<uint8_t> rawdata);
 		void	PrintNextApplicationHeader(TFlashHeader const* pHeader, size_t address) const;
 		void	PrintHeader(TFlashHeader const* pHeader, size_t address) const;
+		void	PrintStreamChecksums() const;
 		std::string GetFlagAsText(uint32_t flags) const;
 
 		uint8_t CalcCRC(uint8_t size, uint16_t address, uint8_t type, uint8_t* data);
 		uint8_t CalcHeaderChecksum(TFlashHeader* header);
 	public:
+		struct TMemoryPatch
+		{
+			uint32_t				Address;
+			std::vector<uint8_t>	Data;
+		};
+
 		CElfReader(std::string filename);
+		/** plans the patched stream as a journal of edits of the source stream and applies it to the patched stream */
 		bool PatchFile(bool appendinfoblock, uint32_t appinfoaddress);
+		/** patched stream as binary file, the journal of PatchFile is applied again if the stream wasn't restructured */
+		bool WritePatchedStream(const std::string& filename) const;
 		bool Deflate();
+		void SetFillOptimization(bool enable, uint32_t minrunlength);
+		void SetBlockMerging(bool enable, uint32_t maxblocklength);
+		/** maximum CRC length of a table entry (one entry is checked per time slice on the target), 0 = entries as generated */
+		void SetCrcBudget(uint32_t budget);
+		/** maximum number of CRC table entries, entries are merged across constant gaps and the largest are kept, 0 = entries as generated */
+		void SetCrcPacking(uint32_t entries);
+		/** per region coverage (loaded, CRC protected, ignored, dropped) and unprotected gaps after ExtractMemoryLayout */
+		void SetCoverageReport(bool enable);
+		/** Merge copies the unchanged records of the file opened by OpenLdrFile and encodes only the changed ones */
+		void SetHexReuse(bool enable);
 		ElfStatus GetState()const { return eElfStatus; }
 		const std::string& GetStateMessage() const;
 		bool ExtractMemoryLayout(bool usestatevectoraddress, uint32_t statevectoraddress);
 		bool OpenLdrFile(std::string existingldr);
 		bool PrintFileTree(bool patchedfile = true) const;
+		void SetPatchCache(CPatchCache* cache);
+		/** CRCs of the memory table entries are looked up in the memo before they are calculated */
+		void SetCrcMemo(CCrcMemo* memo);
+		bool EstimateBootTime(CBootTimeEstimator::TCostModel model, uint32_t bootflags) const;
+		/** patches the memory image after ExtractMemoryLayout, the CRCs of the affected table entries are updated incrementally */
+		bool PatchMemory(const std::vector<TMemoryPatch>& patches);
+		/** writes version and build number into the application info at appinfoaddress with PatchMemory (before PatchFile) */
+		bool StampAppInfo(uint32_t appinfoaddress, uint32_t version, uint32_t build);
+		/** serialized CRC descriptor table (valid after ExtractMemoryLayout) */
+		const CDescriptorTable& GetDescriptorTable() const { return m_DescriptorTable; }
 		bool Merge(std::string patcheldrfile, uint32_t baseaddress);
 		bool CheckIntegrity(std::string filename);
 		virtual ~CElfReader() {};
@@ -9,6 +9,8 @@
 #include <algorithm>
 #include "V303/CElfReader_V303.h"
 #include "V304/CElfReader_V304.h"
+#include "CrcBenchmark.h"
+#include "TableExporter.h"
 
 
 typedef float float32;
@@ -127,6 +129,44 @@ public:
     virtual float32 GetSIUnit(std::string& str) { return std::stof(str); };
 };
 
+class CFrequencyUnit : public CUnitHandler
+{
+public:
+    float32 GetSIUnit(std::string& str) override
+    {
+        static const UnitConverter Units[] = { {"MHz", 1.0e6f, 0.f}, {"kHz", 1.0e3f, 0.f}, {"Hz", 1.f, 0.f} };
+        float32 val;
+        (void)FindAndExtract(sizeof(Units) / sizeof(Units[0]), str, Units, val);
+        return val;
+    }
+}CFrequencyUnit;
+
+/** time values are returned in microseconds */
+class CMicrosecondUnit : public CUnitHandler
+{
+public:
+    float32 GetSIUnit(std::string& str) override
+    {
+        static const UnitConverter Units[] = { {"ms", 1.0e3f, 0.f}, {"us", 1.f, 0.f}, {"s", 1.0e6f, 0.f} };
+        float32 val;
+        (void)FindAndExtract(sizeof(Units) / sizeof(Units[0]), str, Units, val);
+        return val;
+    }
+}CMicrosecondUnit;
+
+/** throughput values are returned in bytes per microsecond (= MB/s) */
+class CThroughputUnit : public CUnitHandler
+{
+public:
+    float32 GetSIUnit(std::string& str) override
+    {
+        static const UnitConverter Units[] = { {"GB/s", 1.0e3f, 0.f}, {"MB/s", 1.f, 0.f}, {"kB/s", 1.0e-3f, 0.f}, {"B/s", 1.0e-6f, 0.f} };
+        float32 val;
+        (void)FindAndExtract(sizeof(Units) / sizeof(Units[0]), str, Units, val);
+        return val;
+    }
+}CThroughputUnit;
+
 class CCallback;
 
 struct CommandLineOption
@@ -865,9 +905,104 @@ constexpr size_t size(T(&)[sz])
     return sz;
 }
 
-static void Execute_V303(std::string& src, std::string& dst, uint32 addr_offset, bool usestatevector, uint32 StateVectorAddress, bool appendinfoblock, uint32 appendinfoblocklocation, bool verify)
+struct DefaultValues
+{
+    std::string Help;
+    std::string src;
+    std::string dst;
+    EN_ProcessorType en_ProcessorType;
+    bool bVectorStateAddress;
+    uint32 u32_VectorStateAddress;
+    uint32 u32_BaseAddress;
+    bool bAppendInfoBlock;
+    uint32 u32_AppendInfoBlockLocation;
+    bool bStampAppInfo;
+    uint32 u32_FwVersion;
+    uint32 u32_FwBuild;
+    bool b_VerifyOutput;
+    bool bOptimizeFill;
+    uint32 u32_MinFillRun;
+    bool bMergeBlocks;
+    uint32 u32_MaxMergedBlock;
+    uint32 u32_CrcBudget;
+    uint32 u32_CrcPackEntries;
+    bool bCoverageReport;
+    bool bReuseHexRecords;
+    bool bEstimateBootTime;
+    uint32 u32_SpiBootFlags;
+    float64 f64_SpiClock;
+    float64 f64_HeaderCost;
+    float64 f64_DMAThroughput;
+    float64 f64_CoreThroughput;
+    float64 f64_FillThroughput;
+    float64 f64_InitCost;
+    float64 f64_CallbackCost;
+    std::string CacheFile;
+    std::string CrcMemoFile;
+    std::string TableSourceFile;
+    std::string TableBinaryFile;
+    std::string TableJsonFile;
+    std::string StreamBinaryFile;
+    bool bVerifyCache;
+    bool bCrcBenchmark;
+    uint32 u32_BenchMaxLength;
+};
+
+static CBootTimeEstimator::TCostModel GetCostModel(const DefaultValues& env)
+{
+    CBootTimeEstimator::TCostModel model = CBootTimeEstimator::GetDefaultModel();
+    model.SpiClockHz = env.f64_SpiClock;
+    model.HeaderOverheadUs = env.f64_HeaderCost;
+    model.DMABytesPerUs = env.f64_DMAThroughput;
+    model.CoreBytesPerUs = env.f64_CoreThroughput;
+    model.FillBytesPerUs = env.f64_FillThroughput;
+    model.InitCostUs = env.f64_InitCost;
+    model.CallbackCostUs = env.f64_CallbackCost;
+    return model;
+}
+
+/** writes the selected exports of the descriptor table, all of them are attempted */
+static bool ExportDescriptorTable(const CDescriptorTable& table, const DefaultValues& env)
+{
+    bool retVal = true;
+    if (!env.TableSourceFile.empty())
+    {
+        retVal = CTableExporter::WriteSource(table, env.TableSourceFile) && retVal;
+    }
+    if (!env.TableBinaryFile.empty())
+    {
+        retVal = CTableExporter::WriteBinary(table, env.TableBinaryFile) && retVal;
+    }
+    if (!env.TableJsonFile.empty())
+    {
+        retVal = CTableExporter::WriteJson(table, env.TableJsonFile) && retVal;
+    }
+    return retVal;
+}
+
+static void Execute_V303(DefaultValues& env)
 {
-    V303::CElfReader reader(src);
+    V303::CElfReader reader(env.src);
+    reader.SetFillOptimization(env.bOptimizeFill, env.u32_MinFillRun);
+    reader.SetBlockMerging(env.bMergeBlocks, env.u32_MaxMergedBlock);
+    reader.SetCrcBudget(env.u32_CrcBudget);
+    reader.SetCrcPacking(env.u32_CrcPackEntries);
+    reader.SetCoverageReport(env.bCoverageReport);
+    reader.SetHexReuse(env.bReuseHexRecords);
+    CPatchCache cache("V303");
+    if (!env.CacheFile.empty())
+    {
+        cache.SetVerification(env.bVerifyCache);
+        (void)cache.Load(env.CacheFile);
+        reader.SetPatchCache(&cache);
+    }
+    CCrcMemo memo;
+    if (!env.CrcMemoFile.empty())
+    {
+        memo.SetVerification(env.bVerifyCache);
+        (void)memo.Load(env.CrcMemoFile);
+        reader.SetCrcMemo(&memo);
+    }
     if (reader.GetState() == V303::CElfReader::ELF_OK)
     {
         std::cerr << "File OK." << std::endl;
@@ -875,19 +1010,40 @@ static void Execute_V303(std::string& src, std::string& dst, uint32 addr_offset,
         {
             std::cerr << "Deflating completed." << std::endl;
 
-            if (reader.ExtractMemoryLayout(usestatevector, StateVectorAddress))
+            if (reader.ExtractMemoryLayout(env.bVectorStateAddress, env.u32_VectorStateAddress))
             {
-                if (reader.PatchFile(appendinfoblock, appendinfoblocklocation))
+                if (!env.CrcMemoFile.empty())
+                {
+                    memo.PrintStatistics();
+                    (void)memo.Save(env.CrcMemoFile);
+                }
+                //the stamp changes the CRCs, the exported table has to contain them
+                const bool stamped = !env.bStampAppInfo || reader.StampAppInfo(env.u32_AppendInfoBlockLocation, env.u32_FwVersion, env.u32_FwBuild);
+                (void)ExportDescriptorTable(reader.GetDescriptorTable(), env);
+                if (stamped && reader.PatchFile(env.bAppendInfoBlock, env.u32_AppendInfoBlockLocation))
                 {
-                    if (reader.OpenLdrFile(src))
+                    if (env.bEstimateBootTime)
                     {
-                        if (reader.Merge(dst, addr_offset))
+                        (void)reader.EstimateBootTime(GetCostModel(env), env.u32_SpiBootFlags);
+                    }
+                    if (!env.StreamBinaryFile.empty())
+                    {
+                        (void)reader.WritePatchedStream(env.StreamBinaryFile);
+                    }
+                    if (reader.OpenLdrFile(env.src))
+                    {
+                        if (reader.Merge(env.dst, env.u32_BaseAddress))
                         {
                             std::cerr << "File successfully merged." << std::endl;
-                            if (verify)
+                            if (!env.CacheFile.empty())
+                            {
+                                cache.PrintStatistics();
+                                (void)cache.Save(env.CacheFile);
+                            }
+                            if (env.b_VerifyOutput)
                             {
                                 std::cerr << "Checking integrity..." << std::endl;
-                                if (reader.CheckIntegrity(dst))
+                                if (reader.CheckIntegrity(env.dst))
                                 {
                                     std::cerr << "Verification succeeded." << std::endl;
                                 }
@@ -932,9 +1088,29 @@ static void Execute_V303(std::string& src, std::string& dst, uint32 addr_offset,
     }
 }
 
-static void Execute_V304(std::string& src, std::string& dst, uint32 addr_offset, bool usestatevector, uint32 StateVectorAddress, bool appendinfoblock, uint32 appendinfoblocklocation, bool verify)
+static void Execute_V304(DefaultValues& env)
 {
-    V304::CElfReader reader(src);
+    V304::CElfReader reader(env.src);
+    reader.SetFillOptimization(env.bOptimizeFill, env.u32_MinFillRun);
+    reader.SetBlockMerging(env.bMergeBlocks, env.u32_MaxMergedBlock);
+    reader.SetCrcBudget(env.u32_CrcBudget);
+    reader.SetCrcPacking(env.u32_CrcPackEntries);
+    reader.SetCoverageReport(env.bCoverageReport);
+    reader.SetHexReuse(env.bReuseHexRecords);
+    CPatchCache cache("V304");
+    if (!env.CacheFile.empty())
+    {
+        cache.SetVerification(env.bVerifyCache);
+        (void)cache.Load(env.CacheFile);
+        reader.SetPatchCache(&cache);
+    }
+    CCrcMemo memo;
+    if (!env.CrcMemoFile.empty())
+    {
+        memo.SetVerification(env.bVerifyCache);
+        (void)memo.Load(env.CrcMemoFile);
+        reader.SetCrcMemo(&memo);
+    }
     if (reader.GetState() == V304::CElfReader::ELF_OK)
     {
         std::cerr << "File OK" << std::endl;
@@ -942,19 +1118,40 @@ static void Execute_V304(std::string& src, std::string& dst, uint32 addr_offset,
         {
             std::cerr << "Deflating completed..." << std::endl;
 
-            if (reader.ExtractMemoryLayout(usestatevector, StateVectorAddress))
+            if (reader.ExtractMemoryLayout(env.bVectorStateAddress, env.u32_VectorStateAddress))
             {
-                if (reader.PatchFile(appendinfoblock, appendinfoblocklocation))
+                if (!env.CrcMemoFile.empty())
                 {
-                    if (reader.OpenLdrFile(src))
+                    memo.PrintStatistics();
+                    (void)memo.Save(env.CrcMemoFile);
+                }
+                //the stamp changes the CRCs, the exported table has to contain them
+                const bool stamped = !env.bStampAppInfo || reader.StampAppInfo(env.u32_AppendInfoBlockLocation, env.u32_FwVersion, env.u32_FwBuild);
+                (void)ExportDescriptorTable(reader.GetDescriptorTable(), env);
+                if (stamped && reader.PatchFile(env.bAppendInfoBlock, env.u32_AppendInfoBlockLocation))
+                {
+                    if (env.bEstimateBootTime)
+                    {
+                        (void)reader.EstimateBootTime(GetCostModel(env), env.u32_SpiBootFlags);
+                    }
+                    if (!env.StreamBinaryFile.empty())
                     {
-                        if (reader.Merge(dst, addr_offset))
+                        (void)reader.WritePatchedStream(env.StreamBinaryFile);
+                    }
+                    if (reader.OpenLdrFile(env.src))
+                    {
+                        if (reader.Merge(env.dst, env.u32_BaseAddress))
                         {
                             std::cerr << "File successfully merged." << std::endl;
-                            if (verify)
+                            if (!env.CacheFile.empty())
+                            {
+                                cache.PrintStatistics();
+                                (void)cache.Save(env.CacheFile);
+                            }
+                            if (env.b_VerifyOutput)
                             {
                                 std::cerr << "Checking integrity..." << std::endl;
-                                if (reader.CheckIntegrity(dst))
+                                if (reader.CheckIntegrity(env.dst))
                                 {
                                     std::cerr << "Verification succeeded." << std::endl;
                                 }
@@ -1002,19 +1199,7 @@ static void Execute_V304(std::string& src, std::string& dst, uint32 addr_offset,
 
 int main(int argc, char** argv)
 {
-    struct DefaultValues
-    {
-        std::string Help;
-        std::string src;
-        std::string dst;
-        EN_ProcessorType en_ProcessorType;
-        bool bVectorStateAddress;
-        uint32 u32_VectorStateAddress;
-        uint32 u32_BaseAddress;
-        bool bAppendInfoBlock;
-        uint32 u32_AppendInfoBlockLocation;
-        bool b_VerifyOutput;
-    }DefEnvironment;
+    DefaultValues DefEnvironment;
     
     static const EN_ProcessorType en_ProcessorType = EN_ProcessorType::EN_PROCESSOR_BF70x;
     static const std::string emptystring = "";
@@ -1023,7 +1208,24 @@ int main(int argc, char** argv)
     static const uint32 baseaddress = 0x3002C;
     static const bool AppendInfoBlock = false;
     static const uint32 AppendInfoBlockLocation = 0x80b00000u;
+    static const bool StampAppInfo = false;
+    static const uint32 FwVersion = 0u;
+    static const uint32 FwBuild = 0u;
     static const bool VerifyOutput = false;
+    static const bool OptimizeFill = false;
+    static const uint32 MinFillRun = 64u;
+    static const bool MergeBlocks = false;
+    static const uint32 MaxMergedBlock = 0x10000u;
+    static const uint32 CrcBudget = 0u; //entries as generated
+    static const uint32 CrcPackEntries = 0u; //entries as generated
+    static const bool CoverageReport = false;
+    static const bool ReuseHexRecords = false;
+    static const bool EstimateBootTime = false;
+    static const uint32 SpiBootFlags = 0x00200000u; //3 address bytes, standard read
+    const CBootTimeEstimator::TCostModel DefaultCostModel = CBootTimeEstimator::GetDefaultModel();
+    static const bool VerifyCache = false;
+    static const bool CrcBenchmark = false;
+    static const uint32 BenchMaxLength = 0x10000000u; //256 MiB
     const CDefaultCallback DefCallBack;
     uint32 VectorStateAddressResolvent = 0u;
     CLocationResolver VectorStateAddressResolutor(VectorStateAddressResolvent);
@@ -1038,7 +1240,36 @@ int main(int argc, char** argv)
     DefEnvironment.u32_BaseAddress = baseaddress;
     DefEnvironment.bAppendInfoBlock = AppendInfoBlock;
     DefEnvironment.u32_AppendInfoBlockLocation = AppendInfoBlockLocation;
+    DefEnvironment.bStampAppInfo = StampAppInfo;
+    DefEnvironment.u32_FwVersion = FwVersion;
+    DefEnvironment.u32_FwBuild = FwBuild;
     DefEnvironment.b_VerifyOutput = VerifyOutput;
+    DefEnvironment.bOptimizeFill = OptimizeFill;
+    DefEnvironment.u32_MinFillRun = MinFillRun;
+    DefEnvironment.bMergeBlocks = MergeBlocks;
+    DefEnvironment.u32_MaxMergedBlock = MaxMergedBlock;
+    DefEnvironment.u32_CrcBudget = CrcBudget;
+    DefEnvironment.u32_CrcPackEntries = CrcPackEntries;
+    DefEnvironment.bCoverageReport = CoverageReport;
+    DefEnvironment.bReuseHexRecords = ReuseHexRecords;
+    DefEnvironment.bEstimateBootTime = EstimateBootTime;
+    DefEnvironment.u32_SpiBootFlags = SpiBootFlags;
+    DefEnvironment.f64_SpiClock = DefaultCostModel.SpiClockHz;
+    DefEnvironment.f64_HeaderCost = DefaultCostModel.HeaderOverheadUs;
+    DefEnvironment.f64_DMAThroughput = DefaultCostModel.DMABytesPerUs;
+    DefEnvironment.f64_CoreThroughput = DefaultCostModel.CoreBytesPerUs;
+    DefEnvironment.f64_FillThroughput = DefaultCostModel.FillBytesPerUs;
+    DefEnvironment.f64_InitCost = DefaultCostModel.InitCostUs;
+    DefEnvironment.f64_CallbackCost = DefaultCostModel.CallbackCostUs;
+    DefEnvironment.CacheFile = emptystring;
+    DefEnvironment.CrcMemoFile = emptystring;
+    DefEnvironment.TableSourceFile = emptystring;
+    DefEnvironment.TableBinaryFile = emptystring;
+    DefEnvironment.TableJsonFile = emptystring;
+    DefEnvironment.StreamBinaryFile = emptystring;
+    DefEnvironment.bVerifyCache = VerifyCache;
+    DefEnvironment.bCrcBenchmark = CrcBenchmark;
+    DefEnvironment.u32_BenchMaxLength = BenchMaxLength;
     bool bPrintRecord = false;
 
     COnHelp OnHelp;
@@ -1056,8 +1287,37 @@ int main(int argc, char** argv)
         {"-offset", "defines address offset ", "", &DefCallBack, EN_DATATYPE::UINT32, sizeof(uint32), &DefEnvironment.u32_BaseAddress, nullptr, &CUint32Range},
         {"-appib", "append info block", "[false/true]", &DefCallBack, EN_DATATYPE::BOOL, sizeof(bool), &DefEnvironment.bAppendInfoBlock, nullptr, nullptr},
         {"-ibloc", "info block location", "", &InfoBlockAddressResolutor, EN_DATATYPE::UINT32, sizeof(uint32), &DefEnvironment.u32_AppendInfoBlockLocation, nullptr, nullptr},
+        {"-stamp", "stamp version and build number into the info block location (CRCs updated incrementally)", "[false/true]", &DefCallBack, EN_DATATYPE::BOOL, sizeof(bool), &DefEnvironment.bStampAppInfo, nullptr, nullptr},
+        {"-fwver", "firmware version number written by -stamp", "", &DefCallBack, EN_DATATYPE::UINT32, sizeof(uint32), &DefEnvironment.u32_FwVersion, nullptr, &CUint32Range},
+        {"-fwbuild", "firmware build number written by -stamp (16 bit)", "", &DefCallBack, EN_DATATYPE::UINT32, sizeof(uint32), &DefEnvironment.u32_FwBuild, nullptr, &CUint32Range},
         {"-verify", "Verify file", "[false/true]", &DefCallBack, EN_DATATYPE::BOOL, sizeof(bool), &DefEnvironment.b_VerifyOutput, nullptr, nullptr},
         {"-r", "Print Record", "[false/true]", &DefCallBack, EN_DATATYPE::BOOL, sizeof(bool), &bPrintRecord, nullptr, nullptr},
+        {"-optfill", "merge fill blocks and convert constant runs into fill blocks", "[false/true]", &DefCallBack, EN_DATATYPE::BOOL, sizeof(bool), &DefEnvironment.bOptimizeFill, nullptr, nullptr},
+        {"-fillrun", "minimum constant run converted into a fill block", "[bytes]", &DefCallBack, EN_DATATYPE::UINT32, sizeof(uint32), &DefEnvironment.u32_MinFillRun, nullptr, &CUint32Range},
+        {"-mergeblk", "merge small adjacent code/data blocks", "[false/true]", &DefCallBack, EN_DATATYPE::BOOL, sizeof(bool), &DefEnvironment.bMergeBlocks, nullptr, nullptr},
+        {"-maxblk", "maximum length of a merged block", "[bytes]", &DefCallBack, EN_DATATYPE::UINT32, sizeof(uint32), &DefEnvironment.u32_MaxMergedBlock, nullptr, &CUint32Range},
+        {"-crcbudget", "maximum CRC block length per time slice, CRC table entries are split/merged (0: off)", "[bytes]", &DefCallBack, EN_DATATYPE::UINT32, sizeof(uint32), &DefEnvironment.u32_CrcBudget, nullptr, &CUint32Range},
+        {"-crcpack", "maximum number of CRC table entries, entries are merged across constant fill gaps to maximize the checked bytes (0: off)", "[entries]", &DefCallBack, EN_DATATYPE::UINT32, sizeof(uint32), &DefEnvironment.u32_CrcPackEntries, nullptr, &CUint32Range},
+        {"-coverage", "report loaded/CRC protected/ignored bytes per memory region and the unprotected gaps", "[false/true]", &DefCallBack, EN_DATATYPE::BOOL, sizeof(bool), &DefEnvironment.bCoverageReport, nullptr, nullptr},
+        {"-hexreuse", "copy the unchanged records of the source hex file, only changed records are encoded", "[false/true]", &DefCallBack, EN_DATATYPE::BOOL, sizeof(bool), &DefEnvironment.bReuseHexRecords, nullptr, nullptr},
+        {"-boottime", "estimate boot time of original and patched stream", "[false/true]", &DefCallBack, EN_DATATYPE::BOOL, sizeof(bool), &DefEnvironment.bEstimateBootTime, nullptr, nullptr},
+        {"-spiclk", "SPI clock of the boot device", "[Hz]", &DefCallBack, EN_DATATYPE::DOUBLE, sizeof(float64), &DefEnvironment.f64_SpiClock, &CFrequencyUnit, nullptr},
+        {"-spimode", "boot flags (fast read, address bytes) of the boot device", "", &DefCallBack, EN_DATATYPE::UINT32, sizeof(uint32), &DefEnvironment.u32_SpiBootFlags, nullptr, &CUint32Range},
+        {"-hdrcost", "processing time per block header", "[us]", &DefCallBack, EN_DATATYPE::DOUBLE, sizeof(float64), &DefEnvironment.f64_HeaderCost, &CMicrosecondUnit, nullptr},
+        {"-dmabw", "copy throughput (DMA access)", "[MB/s]", &DefCallBack, EN_DATATYPE::DOUBLE, sizeof(float64), &DefEnvironment.f64_DMAThroughput, &CThroughputUnit, nullptr},
+        {"-corebw", "copy throughput (core access)", "[MB/s]", &DefCallBack, EN_DATATYPE::DOUBLE, sizeof(float64), &DefEnvironment.f64_CoreThroughput, &CThroughputUnit, nullptr},
+        {"-fillbw", "fill throughput", "[MB/s]", &DefCallBack, EN_DATATYPE::DOUBLE, sizeof(float64), &DefEnvironment.f64_FillThroughput, &CThroughputUnit, nullptr},
+        {"-initcost", "execution time of an init block", "[us]", &DefCallBack, EN_DATATYPE::DOUBLE, sizeof(float64), &DefEnvironment.f64_InitCost, &CMicrosecondUnit, nullptr},
+        {"-cbcost", "execution time of a callback", "[us]", &DefCallBack, EN_DATATYPE::DOUBLE, sizeof(float64), &DefEnvironment.f64_CallbackCost, &CMicrosecondUnit, nullptr},
+        {"-cache", "cache file for incremental patching (CRCs and patched blocks of the previous run)", "", nullptr, EN_DATATYPE::STRING, 0, &DefEnvironment.CacheFile, nullptr, nullptr},
+        {"-cacheverify", "recompute cached results and report mismatches", "[false/true]", &DefCallBack, EN_DATATYPE::BOOL, sizeof(bool), &DefEnvironment.bVerifyCache, nullptr, nullptr},
+        {"-crcmemo", "CRC memo file shared by all projects/variants (CRCs of memory blocks seen before are not recalculated)", "", nullptr, EN_DATATYPE::STRING, 0, &DefEnvironment.CrcMemoFile, nullptr, nullptr},
+        {"-tblc", "write the CRC descriptor table as C initializer source", "", nullptr, EN_DATATYPE::STRING, 0, &DefEnvironment.TableSourceFile, nullptr, nullptr},
+        {"-tblbin", "write the CRC descriptor table in target layout (binary)", "", nullptr, EN_DATATYPE::STRING, 0, &DefEnvironment.TableBinaryFile, nullptr, nullptr},
+        {"-tbljson", "write the CRC descriptor table as JSON", "", nullptr, EN_DATATYPE::STRING, 0, &DefEnvironment.TableJsonFile, nullptr, nullptr},
+        {"-ldrbin", "write the patched boot stream as binary file", "", nullptr, EN_DATATYPE::STRING, 0, &DefEnvironment.StreamBinaryFile, nullptr, nullptr},
+        {"-crcbench", "check the CRC back-ends against the reference and measure their throughput (no patching)", "[false/true]", &DefCallBack, EN_DATATYPE::BOOL, sizeof(bool), &DefEnvironment.bCrcBenchmark, nullptr, nullptr},
+        {"-benchmax", "largest buffer of the CRC benchmark", "[bytes]", &DefCallBack, EN_DATATYPE::UINT32, sizeof(uint32), &DefEnvironment.u32_BenchMaxLength, nullptr, &CUint32Range},
     };
 
     OnHelp.InitHelp(size(CommandLineOptions), CommandLineOptions);
@@ -1098,13 +1358,17 @@ int main(int argc, char** argv)
         PrintRecordSet(sizeof(CommandLineOptions) / sizeof(CommandLineOptions[0]), &CommandLineOptions[0]);
     }
     
-    if (DefEnvironment.en_ProcessorType != EN_ProcessorType::EN_PROCESSOR_BF70x)
+    if (DefEnvironment.bCrcBenchmark == true)
+    {
+        (void)CCrcBenchmark::Run(DefEnvironment.u32_BenchMaxLength, 1u);
+    }
+    else if (DefEnvironment.en_ProcessorType != EN_ProcessorType::EN_PROCESSOR_BF70x)
     {
-        Execute_V303(DefEnvironment.src, DefEnvironment.dst, DefEnvironment.u32_BaseAddress, DefEnvironment.bVectorStateAddress, DefEnvironment.u32_VectorStateAddress, DefEnvironment.bAppendInfoBlock, DefEnvironment.u32_AppendInfoBlockLocation, DefEnvironment.b_VerifyOutput);
+        Execute_V303(DefEnvironment);
     }
     else
     {
-        Execute_V304(DefEnvironment.src, DefEnvironment.dst, DefEnvironment.u32_BaseAddress, DefEnvironment.bVectorStateAddress, DefEnvironment.u32_VectorStateAddress, DefEnvironment.bAppendInfoBlock, DefEnvironment.u32_AppendInfoBlockLocation, DefEnvironment.b_VerifyOutput);
+        Execute_V304(DefEnvironment);
     }    
 }
 